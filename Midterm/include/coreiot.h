@@ -4,6 +4,11 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include "global.h"
+#include "sensor_snapshot.h"
+#include "telemetry_journal.h"
+#include "telemetry_filter.h"
+#include "json_arena.h"
+#include "epoch_time.h"
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
 
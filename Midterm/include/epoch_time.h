@@ -0,0 +1,10 @@
+#ifndef __EPOCH_TIME_H__
+#define __EPOCH_TIME_H__
+
+#include <Arduino.h>
+
+// Wall clock for telemetry timestamps, set by SNTP once WiFi is up.
+// Returns Unix time in ms, or 0 while the clock has not been synced yet.
+int64_t epoch_ms();
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef __I2C_BUS_H__
+#define __I2C_BUS_H__
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+// Single owner of the Wire bus. Drivers hand it transactions through a queue and
+// sleep until the bus task has run them; high priority work (sensor reads) always
+// goes before queued low priority work (LCD updates), so a sensor read waits for
+// at most one LCD transaction, never for a whole repaint.
+#define I2C_BUS_QUEUE_LENGTH    16
+#define I2C_BUS_TASK_PRIORITY   5
+#define I2C_BUS_TASK_STACK      3072
+#define I2C_BUS_CLOCK_HZ        100000
+
+#define I2C_BUS_OK              0
+#define I2C_BUS_ERROR_QUEUE     -1      // queue full or bus not started
+#define I2C_BUS_ERROR_READ      -2      // fewer bytes than requested
+
+typedef enum {
+    I2C_PRIORITY_HIGH = 0,
+    I2C_PRIORITY_LOW,
+    I2C_PRIORITY_COUNT
+} I2cPriority;
+
+typedef struct {
+    uint32_t transactions[I2C_PRIORITY_COUNT];
+    uint32_t errors;
+    uint32_t max_latency_us[I2C_PRIORITY_COUNT];    // submit to completion
+    uint64_t total_latency_us[I2C_PRIORITY_COUNT];
+    uint64_t busy_us;                               // time spent on the wire
+    int64_t  window_us;                             // length of the measurement window
+} I2cBusStats;
+
+// Starts Wire on the given pins and the bus task. Call once before any transfer.
+bool i2c_bus_begin(int sda, int scl, uint32_t clock_hz = I2C_BUS_CLOCK_HZ);
+
+// Write tx (may be empty), then read rx_len bytes with a repeated start if tx_len > 0.
+// Blocks the calling task until done; returns I2C_BUS_OK, a Wire error code (1..5)
+// or one of the I2C_BUS_ERROR_* codes. Leaves the caller's task notification alone.
+int i2c_bus_transfer(uint8_t address, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len,
+                     I2cPriority priority = I2C_PRIORITY_LOW);
+
+// Transfer hook for the DHT20 and LiquidCrystal_I2C drivers, ctx is the I2cPriority.
+int i2c_bus_transfer_hook(uint8_t address, const uint8_t *tx, uint8_t tx_len, uint8_t *rx, uint8_t rx_len, void *ctx);
+
+// Copies the counters since the last reset; utilisation = busy_us / window_us.
+void i2c_bus_get_stats(I2cBusStats &out, bool reset = false);
+
+#endif
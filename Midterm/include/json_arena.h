@@ -0,0 +1,23 @@
+#ifndef __JSON_ARENA_H__
+#define __JSON_ARENA_H__
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Fixed pool of preallocated JsonDocuments for inbound MQTT and WebSocket messages.
+// A slot is taken for one message and cleared on release, so the receive path never
+// touches the heap. JSON_ARENA_BYTES covers the largest message seen so far
+// (json_arena_high_water()), with headroom; raise it if that gets close.
+#define JSON_ARENA_SLOTS 2
+#define JSON_ARENA_BYTES 384
+
+// Returns a cleared document, or NULL if every slot is in use (drop the message).
+JsonDocument *json_arena_acquire();
+
+// Records the memory the message needed and hands the slot back.
+void json_arena_release(JsonDocument *doc);
+
+// Largest memoryUsage() of any released document since boot.
+size_t json_arena_high_water();
+
+#endif
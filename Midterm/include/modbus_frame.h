@@ -0,0 +1,137 @@
+#ifndef __MODBUS_FRAME_H__
+#define __MODBUS_FRAME_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compile-time Modbus RTU frames. A fixed request is written as
+//     modbus::read_holding<6, 0x01F6, 1>()
+// and the complete ADU, CRC included, is a constant array in flash; nothing is built
+// or checksummed at run time. Kept to C++11 constexpr so it builds with every core.
+namespace modbus
+{
+    constexpr uint16_t crc_bits(uint16_t crc, int bits)
+    {
+        return bits == 0 ? crc : crc_bits((crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1, bits - 1);
+    }
+
+    constexpr uint16_t crc16(uint16_t crc)
+    {
+        return crc;
+    }
+
+    template <typename... Rest>
+    constexpr uint16_t crc16(uint16_t crc, uint8_t first, Rest... rest)
+    {
+        return crc16(crc_bits(crc ^ first, 8), rest...);
+    }
+
+    constexpr uint8_t hi(uint16_t value)
+    {
+        return value >> 8;
+    }
+
+    constexpr uint8_t lo(uint16_t value)
+    {
+        return value & 0xFF;
+    }
+
+    // The ADU for the given slave, function and data bytes.
+    template <uint8_t... Bytes>
+    struct Adu
+    {
+        static constexpr uint16_t crc = crc16(0xFFFF, Bytes...);
+        static constexpr size_t length = sizeof...(Bytes) + 2;
+        static constexpr uint8_t frame[length] = {Bytes..., lo(crc), hi(crc)};
+    };
+
+    template <uint8_t... Bytes>
+    constexpr uint8_t Adu<Bytes...>::frame[];
+
+    template <size_t N>
+    using Frame = const uint8_t (&)[N];
+
+    // Length of every read and single write request below
+    constexpr size_t request_length = 8;
+
+    template <uint8_t Slave, uint16_t Address, uint16_t Count>
+    constexpr Frame<request_length> read_coils()
+    {
+        static_assert(Count >= 1 && Count <= 2000, "Modbus allows 1..2000 coils per read");
+        return Adu<Slave, 0x01, hi(Address), lo(Address), hi(Count), lo(Count)>::frame;
+    }
+
+    template <uint8_t Slave, uint16_t Address, uint16_t Count>
+    constexpr Frame<request_length> read_holding()
+    {
+        static_assert(Count >= 1 && Count <= 125, "Modbus allows 1..125 registers per read");
+        return Adu<Slave, 0x03, hi(Address), lo(Address), hi(Count), lo(Count)>::frame;
+    }
+
+    template <uint8_t Slave, uint16_t Address, uint16_t Count>
+    constexpr Frame<request_length> read_input()
+    {
+        static_assert(Count >= 1 && Count <= 125, "Modbus allows 1..125 registers per read");
+        return Adu<Slave, 0x04, hi(Address), lo(Address), hi(Count), lo(Count)>::frame;
+    }
+
+    template <uint8_t Slave, uint16_t Address, bool On>
+    constexpr Frame<request_length> write_coil()
+    {
+        return Adu<Slave, 0x05, hi(Address), lo(Address), On ? 0xFF : 0x00, 0x00>::frame;
+    }
+
+    template <uint8_t Slave, uint16_t Address, uint16_t Value>
+    constexpr Frame<request_length> write_register()
+    {
+        return Adu<Slave, 0x06, hi(Address), lo(Address), hi(Value), lo(Value)>::frame;
+    }
+
+    // Single coil writes for Count consecutive coils, frames[i][on] switches coil First + i,
+    // so a coil picked at run time still goes out as a constant frame
+    template <uint8_t Slave, uint16_t First, size_t... I>
+    struct CoilWrites
+    {
+        static constexpr const uint8_t *frames[sizeof...(I)][2] = {
+            {write_coil<Slave, First + I, false>(), write_coil<Slave, First + I, true>()}...};
+    };
+
+    template <uint8_t Slave, uint16_t First, size_t... I>
+    constexpr const uint8_t *CoilWrites<Slave, First, I...>::frames[sizeof...(I)][2];
+
+    template <uint8_t Slave, uint16_t First, size_t N, size_t... I>
+    struct MakeCoilWrites : MakeCoilWrites<Slave, First, N - 1, N - 1, I...>
+    {
+    };
+
+    template <uint8_t Slave, uint16_t First, size_t... I>
+    struct MakeCoilWrites<Slave, First, 0, I...>
+    {
+        typedef CoilWrites<Slave, First, I...> type;
+    };
+
+    // 256 entry table for the run-time CRC of frames built on the fly
+    template <size_t... I>
+    struct CrcTable
+    {
+        static constexpr uint16_t values[sizeof...(I)] = {crc_bits(I, 8)...};
+    };
+
+    template <size_t... I>
+    constexpr uint16_t CrcTable<I...>::values[];
+
+    template <size_t N, size_t... I>
+    struct MakeCrcTable : MakeCrcTable<N - 1, N - 1, I...>
+    {
+    };
+
+    template <size_t... I>
+    struct MakeCrcTable<0, I...>
+    {
+        typedef CrcTable<I...> type;
+    };
+
+    typedef MakeCrcTable<256>::type crc_table;
+}
+
+#endif
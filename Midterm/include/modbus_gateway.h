@@ -0,0 +1,40 @@
+#ifndef __MODBUS_GATEWAY_H__
+#define __MODBUS_GATEWAY_H__
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "modbus_master.h"
+
+// Modbus TCP server forwarding PDUs to the RS485 master. One task owns every socket:
+// requests from all clients go into one table, reads are answered from a short-lived
+// cache when possible, identical reads already on the bus share its reply, and at most
+// GATEWAY_PER_SLAVE requests per slave are queued on the master at a time, so one
+// chatty client cannot fill the bus queue ahead of everyone else.
+#define GATEWAY_PORT            502
+#define GATEWAY_MAX_CLIENTS     4
+#define GATEWAY_MAX_PENDING     16      // transactions waiting for or on the bus
+#define GATEWAY_PER_SLAVE       1
+#define GATEWAY_CACHE_ENTRIES   16
+#define GATEWAY_CACHE_TTL_MS    500
+#define GATEWAY_POLL_MS         5
+#define GATEWAY_TASK_STACK      6144
+#define GATEWAY_TASK_PRIORITY   2
+
+typedef struct {
+    uint32_t requests;
+    uint32_t cache_hits;
+    uint32_t coalesced;         // answered by a bus read started for another request
+    uint32_t bus_requests;
+    uint32_t busy_rejects;      // answered with exception 0x06, table full
+} GatewayStats;
+
+// Starts the gateway task; it opens the port once Wi-Fi is connected.
+bool modbus_gateway_begin(ModbusMaster *bus);
+
+// Drops every cached read. For writes that reach the bus without going through the
+// gateway (the relay controller); safe from any task.
+void modbus_gateway_invalidate_cache();
+
+void modbus_gateway_get_stats(GatewayStats &out, bool reset = false);
+
+#endif
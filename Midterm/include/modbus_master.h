@@ -0,0 +1,120 @@
+#ifndef __MODBUS_MASTER_H__
+#define __MODBUS_MASTER_H__
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+// Modbus RTU master. Each bus has its own task and request queue; the task sends one
+// frame, waits for the reply frame (ended by the 3.5 character gap, detected by the
+// transport), checks address, function and CRC, retries on timeout or a bad frame and
+// completes the request through its callback. Nothing waits longer than the reply takes.
+#define MODBUS_MAX_ADU              256     // slave + PDU + CRC
+#define MODBUS_MAX_PDU              253
+#define MODBUS_QUEUE_LENGTH         16
+#define MODBUS_TASK_STACK           4096
+#define MODBUS_TASK_PRIORITY        3
+#define MODBUS_DEFAULT_TIMEOUT_MS   100     // per attempt, until the reply frame has ended
+#define MODBUS_DEFAULT_RETRIES      2
+#define MODBUS_BROADCAST_DELAY_MS   20      // turnaround after a broadcast, no reply expected
+
+#define MODBUS_OK                   0
+#define MODBUS_ERROR_TIMEOUT        -1      // no reply
+#define MODBUS_ERROR_CRC            -2
+#define MODBUS_ERROR_FRAME          -3      // wrong slave, function or length
+#define MODBUS_ERROR_EXCEPTION      -4      // slave answered with an exception code
+#define MODBUS_ERROR_QUEUE          -5      // queue full or bus not started
+#define MODBUS_ERROR_SEND           -6
+
+#define MODBUS_BROADCAST            0
+
+// Function codes used by this project
+#define MODBUS_READ_COILS           0x01
+#define MODBUS_READ_HOLDING         0x03
+#define MODBUS_READ_INPUT           0x04
+#define MODBUS_WRITE_COIL           0x05
+#define MODBUS_WRITE_REGISTER       0x06
+#define MODBUS_WRITE_COILS          0x0F
+#define MODBUS_WRITE_REGISTERS      0x10
+
+// Frame transport under the master, e.g. an RS485 UART.
+typedef struct {
+    void *ctx;
+    // Drops stale input, then sends one complete frame. Returns false on error.
+    bool (*send)(void *ctx, const uint8_t *frame, size_t length);
+    // Waits up to timeout_ms for a frame terminated by the inter-frame gap. Returns the
+    // frame in a transport buffer and its length in *length, or NULL on timeout. The
+    // master checks it in place and hands it back with release().
+    const uint8_t *(*receive)(void *ctx, size_t *length, uint32_t timeout_ms);
+    void (*release)(void *ctx, const uint8_t *frame);
+} ModbusTransport;
+
+typedef struct {
+    int           status;       // MODBUS_OK or MODBUS_ERROR_*
+    uint8_t       slave;
+    uint8_t       function;     // as requested, without the exception bit
+    uint8_t       exception;    // exception code if status == MODBUS_ERROR_EXCEPTION
+    const uint8_t *data;        // reply PDU after the function code, valid during the callback only
+    size_t        length;
+} ModbusResult;
+
+// Runs on the bus task; keep it short and never submit-and-wait from here.
+typedef void (*ModbusCallback)(const ModbusResult &result, void *ctx);
+
+// A request is copied into the queue, so it may live on the caller's stack.
+typedef struct {
+    uint8_t        frame[MODBUS_MAX_ADU];   // complete ADU including the CRC
+    uint16_t       length;
+    uint16_t       timeout_ms;
+    uint8_t        retries;
+    ModbusCallback callback;
+    void           *ctx;
+} ModbusRequest;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t retries;
+    uint32_t timeouts;
+    uint32_t crc_errors;
+    uint32_t frame_errors;
+    uint32_t exceptions;
+    uint32_t max_latency_us;    // submit to completion
+} ModbusStats;
+
+typedef struct ModbusMaster ModbusMaster;
+
+// Table driven, for frames built at run time; constant frames come from modbus_frame.h.
+uint16_t modbus_crc16(const uint8_t *data, size_t length);
+
+// Starts the bus task on top of transport, which must outlive the master.
+ModbusMaster *modbus_master_begin(const ModbusTransport *transport, const char *name = "modbus");
+
+// Builds the ADU (slave, function, data, CRC) with the default timeout and retries
+// and no callback. Returns false if the PDU is too long.
+bool modbus_request_init(ModbusRequest &request, uint8_t slave, uint8_t function,
+                         const uint8_t *data, size_t length);
+
+// Wraps a complete ADU with its CRC already in place, e.g. a constant frame.
+bool modbus_request_init_frame(ModbusRequest &request, const uint8_t *frame, size_t length);
+
+// Queues the request; the callback reports the result. Returns false if the queue stays full for wait.
+bool modbus_master_submit(ModbusMaster *bus, const ModbusRequest &request, TickType_t wait = portMAX_DELAY);
+
+// Queues the request and blocks until it completes. Copies up to size bytes of the reply
+// data (after the function code) into data and returns the status. Leaves the caller's
+// task notification alone; request.callback and request.ctx are replaced.
+int modbus_master_transact(ModbusMaster *bus, ModbusRequest &request, uint8_t *data = NULL, size_t size = 0,
+                           size_t *length = NULL);
+
+// Blocking read of count holding (0x03) or input (0x04) registers.
+int modbus_read_registers(ModbusMaster *bus, uint8_t slave, uint8_t function, uint16_t address,
+                          uint16_t count, uint16_t *values);
+
+// Same for a prebuilt 0x03/0x04 request, e.g. modbus::read_holding<6, 0x01F6, 1>().
+int modbus_read_registers_frame(ModbusMaster *bus, const uint8_t *frame, size_t length, uint16_t *values);
+
+void modbus_master_get_stats(ModbusMaster *bus, ModbusStats &out, bool reset = false);
+
+#endif
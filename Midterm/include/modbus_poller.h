@@ -0,0 +1,51 @@
+#ifndef __MODBUS_POLLER_H__
+#define __MODBUS_POLLER_H__
+
+#include <Arduino.h>
+#include "modbus_master.h"
+
+// Periodic polling of declared register points. Each tick the points that are due are
+// grouped per slave and function, and registers close to each other are read as one
+// block (gaps up to POLL_MAX_GAP registers are read and thrown away). Every point
+// inside a block gets the new value, due or not. All blocks of a tick are queued on
+// the bus at once and the tick ends when the last one completes.
+#define POLL_MAX_POINTS     32
+#define POLL_MAX_GAP        8       // unused registers worth reading to save a transaction
+#define POLL_MAX_BLOCK      125     // registers per read, the Modbus limit
+#define POLL_TICK_MS        100
+#define POLL_TASK_STACK     4096
+#define POLL_TASK_PRIORITY  2
+
+typedef struct PollPoint PollPoint;
+
+// Runs on the bus task with the scaled value.
+typedef void (*PollValueFn)(const PollPoint &point, float value);
+
+struct PollPoint {
+    const char  *name;
+    uint8_t     slave;
+    uint8_t     function;       // MODBUS_READ_HOLDING or MODBUS_READ_INPUT
+    uint16_t    address;
+    bool        is_signed;      // int16 instead of uint16
+    float       scale;          // value = raw * scale
+    uint32_t    period_ms;
+    PollValueFn on_value;
+    void        *ctx;
+};
+
+typedef struct {
+    uint32_t cycles;            // ticks that read anything
+    uint32_t transactions;
+    uint32_t points_updated;
+    uint32_t errors;            // failed block reads
+} PollerStats;
+
+// Starts polling; points must stay valid for the lifetime of the program. frames are
+// optional prebuilt read requests, e.g. modbus::read_holding<6, 0x01F6, 4>(); a block
+// that matches one exactly is sent as that constant frame instead of being built.
+bool modbus_poller_begin(ModbusMaster *bus, const PollPoint *points, size_t count,
+                         const uint8_t *const *frames = NULL, size_t frame_count = 0);
+
+void modbus_poller_get_stats(PollerStats &out, bool reset = false);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef __RELAY_CONTROLLER_H__
+#define __RELAY_CONTROLLER_H__
+
+#include <Arduino.h>
+#include "modbus_master.h"
+
+// Relay board on the RS485 bus. Callers (web page, RPC, rules) only change the wanted
+// state; once per tick the controller compares it with a shadow of the coils, writes
+// every change of that tick in one frame (a constant write-single-coil (0x05) frame for
+// one relay, write-multiple-coils (0x0F) for more) and reads the coils back to update
+// the shadow. Nothing is sent when nothing changed.
+#define RELAY_SLAVE             1
+#define RELAY_FIRST_COIL        0
+#define RELAY_COUNT             4
+#define RELAY_ALL_MASK          ((1UL << RELAY_COUNT) - 1)
+#define RELAY_TICK_MS           50
+#define RELAY_RETRY_MAX_MS      5000    // backoff cap while the board does not answer or a write does not stick
+#define RELAY_TASK_STACK        4096
+#define RELAY_TASK_PRIORITY     2
+
+// Reads the current coils into the shadow and starts the controller task.
+bool relay_controller_begin(ModbusMaster *bus);
+
+bool relay_set(uint8_t relay, bool on);
+
+// Sets the relays whose bit is set in mask to the matching bit of values.
+void relay_set_mask(uint32_t mask, uint32_t values);
+
+// Makes the controller re-read the coils after something else wrote them (the Modbus
+// TCP gateway); relays without an unwritten change take the board's state. Any task.
+void relay_controller_invalidate();
+
+// Wanted state, including changes not written yet.
+bool relay_get(uint8_t relay);
+
+// Coils as last read back from the board; false in *known until the first read succeeded.
+uint32_t relay_confirmed_state(bool *known = NULL);
+
+#endif
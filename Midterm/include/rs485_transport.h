@@ -0,0 +1,26 @@
+#ifndef __RS485_TRANSPORT_H__
+#define __RS485_TRANSPORT_H__
+
+#include <Arduino.h>
+#include "driver/uart.h"
+#include "modbus_master.h"
+
+// Modbus RTU transport on the ESP-IDF UART driver. Received bytes arrive through the
+// driver's event queue; the RX timeout event after RS485_FRAME_GAP_SYMBOLS character
+// times of silence (the 3.5 character gap rounded up) ends a frame, which the driver
+// copies straight into a pooled frame buffer that the master reads in place. With a
+// DE pin the UART drives the transceiver direction itself (RS485 half-duplex mode).
+#define RS485_UART_PORT         UART_NUM_1
+#define RS485_BAUD              9600
+#define RS485_FRAME_GAP_SYMBOLS 4
+#define RS485_RX_BUFFER         512
+#define RS485_EVENT_QUEUE       16
+#define RS485_FRAME_POOL        2
+#define RS485_TX_TIMEOUT_MS     100
+
+// Installs the driver and returns the transport for modbus_master_begin(). de_pin < 0
+// is for transceivers that switch direction on their own. One port only.
+const ModbusTransport *rs485_transport_begin(uart_port_t port, uint32_t baud, int rx_pin, int tx_pin,
+                                             int de_pin = -1);
+
+#endif
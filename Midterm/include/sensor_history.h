@@ -0,0 +1,53 @@
+#ifndef __SENSOR_HISTORY_H__
+#define __SENSOR_HISTORY_H__
+
+#include <Arduino.h>
+
+// Fixed-memory history of every sensor channel: raw samples for the last few minutes
+// plus min/max/avg rollups at 1-minute and 15-minute resolution. All storage is static.
+#define HISTORY_RAW_SAMPLES     128     // ~2 min at the 1 s RS485 poll rate, ~10 min for DHT20
+#define HISTORY_MINUTE_ROLLUPS  60      // last hour
+#define HISTORY_QUARTER_ROLLUPS 96      // last 24 hours
+
+typedef enum {
+    SENSOR_TEMPERATURE = 0,
+    SENSOR_HUMIDITY,
+    SENSOR_SOUND,
+    SENSOR_PRESSURE,
+    SENSOR_CHANNEL_COUNT
+} SensorChannel;
+
+typedef enum {
+    HISTORY_1_MIN = 0,
+    HISTORY_15_MIN,
+    HISTORY_RESOLUTION_COUNT
+} HistoryResolution;
+
+typedef struct {
+    int64_t timestamp_us;
+    float   value;
+} SensorSample;
+
+typedef struct {
+    uint32_t start_s;       // bucket start, seconds since boot
+    float    min;
+    float    max;
+    float    avg;
+    uint16_t count;
+} SensorRollup;
+
+// Append one sample; timestamp_us is esp_timer time (0 = now). Safe from any task.
+void sensor_history_record(SensorChannel channel, float value, int64_t timestamp_us = 0);
+
+// Copy up to max_count of the most recent raw samples, oldest first. Returns the number copied.
+size_t sensor_history_raw(SensorChannel channel, SensorSample *out, size_t max_count);
+
+// Copy up to max_count of the most recent closed rollups, oldest first. Returns the number copied.
+size_t sensor_history_rollups(SensorChannel channel, HistoryResolution resolution, SensorRollup *out, size_t max_count);
+
+// Latest raw sample of a channel, false if the channel has no samples yet.
+bool sensor_history_latest(SensorChannel channel, SensorSample &out);
+
+const char *sensor_history_channel_name(SensorChannel channel);
+
+#endif
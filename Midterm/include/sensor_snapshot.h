@@ -0,0 +1,30 @@
+#ifndef __SENSOR_SNAPSHOT_H__
+#define __SENSOR_SNAPSHOT_H__
+
+#include <Arduino.h>
+
+// Latest DHT20 reading, published by temp_humi_monitor and read by every other task.
+// sequence counts published samples (0 = nothing published yet), timestamp_us is esp_timer time.
+typedef struct {
+    float    temperature;
+    float    humidity;
+    uint32_t sequence;
+    int64_t  timestamp_us;
+    bool     valid;
+} SensorSnapshot;
+
+// Single writer only: called from the sensor task, never blocks.
+void sensor_snapshot_publish(float temperature, float humidity, bool valid);
+
+// Lock-free read of the latest snapshot. Retries while the writer is mid-update and
+// returns false if no consistent copy could be taken (caller keeps its previous copy).
+bool sensor_snapshot_read(SensorSnapshot &out);
+
+// Sequence of the latest published sample, a single atomic load.
+uint32_t sensor_snapshot_sequence();
+
+// Reads the latest snapshot if it is newer than last_sequence. last_sequence only advances
+// (to the sequence of the copy) once a consistent read succeeded, so no sample is skipped.
+bool sensor_snapshot_read_newer(uint32_t &last_sequence, SensorSnapshot &out);
+
+#endif
@@ -6,7 +6,13 @@
 #include <Arduino_MQTT_Client.h>
 #include <HTTPClient.h>
 #include "task_check_info.h"
+#include "telemetry_filter.h"
+#include "relay_controller.h"
+#include "sensor_history.h"
+#include "epoch_time.h"
 
+// Call once before the first CORE_IOT_reconnect()
+void CORE_IOT_setup();
 void CORE_IOT_sendata(String mode, String feed, String data);
 void CORE_IOT_reconnect();
 
@@ -4,6 +4,8 @@
 
 #include <ArduinoJson.h>
 #include <task_check_info.h>
+#include "relay_controller.h"
+#include "json_arena.h"
 
-extern void handleWebSocketMessage(String message);
+extern void handleWebSocketMessage(uint8_t *data, size_t len);
 #endif
\ No newline at end of file
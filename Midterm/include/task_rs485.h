@@ -1,7 +1,17 @@
 #ifndef __TASK_RS485_H__
 #define __TASK_RS485_H__
 
-#include <HardwareSerial.h>
 #include <Arduino.h>
+#include "sensor_history.h"
+#include "modbus_master.h"
+#include "modbus_frame.h"
+#include "modbus_poller.h"
+#include "relay_controller.h"
+#include "rs485_transport.h"
+#include "modbus_gateway.h"
+
+extern ModbusMaster *rs485_bus;
+
+void tasksensor_init();
 
 #endif
\ No newline at end of file
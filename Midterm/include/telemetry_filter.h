@@ -0,0 +1,34 @@
+#ifndef __TELEMETRY_FILTER_H__
+#define __TELEMETRY_FILTER_H__
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Report-by-exception filter in front of the telemetry path. Every key has a policy;
+// a value is reported when it is the first one, when the heartbeat expired, or when it
+// moved past the deadband, but never sooner than min_interval_ms after the last report.
+#define FILTER_MAX_KEYS             16
+#define FILTER_KEY_LENGTH           24
+#define FILTER_DEFAULT_HEARTBEAT_MS 300000      // unknown keys: any change, plus a 5 min heartbeat
+
+// Shared attribute holding the policies, e.g.
+// {"temperature":{"deadband":0.2,"relative":0,"minInterval":10,"heartbeat":300}, ...}
+// (intervals in seconds). A string attribute containing the same JSON is accepted too.
+#define FILTER_POLICY_ATTR          "telemetryPolicy"
+
+typedef struct {
+    float    abs_deadband;      // report when |value - last| >= abs_deadband (0 = unused)
+    float    rel_deadband;      // report when |value - last| >= rel_deadband * |last| (0 = unused)
+    uint32_t min_interval_ms;   // 0 = no rate limit
+    uint32_t heartbeat_ms;      // report an unchanged value after this long (0 = never)
+} ReportPolicy;
+
+bool telemetry_filter_set_policy(const char *key, const ReportPolicy &policy);
+
+// Decides whether value should go on the air and, if so, records it as the last reported value.
+bool telemetry_filter_should_report(const char *key, float value);
+
+// Applies FILTER_POLICY_ATTR from a shared attribute update; returns the number of keys updated.
+size_t telemetry_filter_apply_attribute(JsonVariantConst policies);
+
+#endif
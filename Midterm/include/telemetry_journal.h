@@ -0,0 +1,39 @@
+#ifndef __TELEMETRY_JOURNAL_H__
+#define __TELEMETRY_JOURNAL_H__
+
+#include <Arduino.h>
+#include "LittleFS.h"
+
+// Store-and-forward journal for telemetry produced while the uplink is down.
+// Records are appended to fixed-size segment files under JOURNAL_DIR; when the
+// budget is exhausted the oldest segment is dropped. Each record is framed as
+//   magic(2) | length(2) | crc32(4) | ts_ms(8) | values JSON (length bytes)
+// with the CRC covering ts_ms and the JSON, so a torn write at power loss is
+// detected and the rest of that segment is skipped.
+#define JOURNAL_DIR                 "/journal"
+#define JOURNAL_SEGMENT_BYTES       (16 * 1024)
+#define JOURNAL_MAX_SEGMENTS        8           // 128 KB, ~2000 DHT20 samples / ~5.5 h
+#define JOURNAL_MAX_RECORD          192         // values JSON of a single record
+#define JOURNAL_BATCH_BYTES         1024        // must fit the MQTT client buffer
+#define JOURNAL_DRAIN_INTERVAL_MS   2000        // at most one backlog batch per interval
+
+// Publishes one batch, a ThingsBoard telemetry array. Returns false to keep the
+// records in the journal and retry them on a later drain.
+typedef bool (*JournalPublishFn)(const char *payload, size_t length);
+
+// Mounts LittleFS if needed and recovers the segment range and read cursor.
+bool telemetry_journal_begin();
+
+// ts_ms is Unix time in ms, 0 if the clock is not synced yet (server time is used on upload).
+bool telemetry_journal_append(int64_t ts_ms, const char *values_json);
+
+// Sends at most one batch of the oldest records, rate limited by JOURNAL_DRAIN_INTERVAL_MS.
+// Returns the number of records removed from the journal.
+size_t telemetry_journal_drain(JournalPublishFn publish);
+
+bool telemetry_journal_empty();
+
+// Records evicted unsent since boot because the journal was full.
+uint32_t telemetry_journal_dropped();
+
+#endif
@@ -4,6 +4,9 @@
 #include "LiquidCrystal_I2C.h"
 #include "DHT20.h"
 #include "global.h"
+#include "i2c_bus.h"
+#include "sensor_snapshot.h"
+#include "sensor_history.h"
 
 void temp_humi_monitor(void *pvParameters);
 
@@ -6,7 +6,7 @@
 #include "dht_anomaly_model.h"
 #include "config.h"
 #include "leds.h"
-#include "temp_humi.h"
+#include "sensor_snapshot.h"
 
 // TensorFlow Lite Micro headers
 #include <TensorFlowLite_ESP32.h>
@@ -18,6 +18,8 @@ const uint8_t DHT20_ADDRESS = 0x38;
 DHT20::DHT20(TwoWire *wire)
 {
   _wire        = wire;
+  _transfer    = NULL;
+  _transferCtx = NULL;
   //  reset() ?
   _temperature = 0;
   _humidity    = 0;
@@ -26,12 +28,34 @@ DHT20::DHT20(TwoWire *wire)
   _status      = DHT20_OK;
   _lastRequest = 0;
   _lastRead    = 0;
+
+  _converting  = false;
+  _readyAt     = 0;
+  _ready       = false;
+  _callback    = NULL;
+  _callbackArg = NULL;
+#if defined(ESP32)
+  _timer       = NULL;
+#endif
+}
+
+
+DHT20::~DHT20()
+{
+#if defined(ESP32)
+  if (_timer != NULL)
+  {
+    esp_timer_stop(_timer);
+    esp_timer_delete(_timer);
+  }
+#endif
 }
 
 
 bool DHT20::begin()
 {
-  _wire->begin();
+  //  a transfer hook owns the bus, it is started elsewhere
+  if (_transfer == NULL) _wire->begin();
   //  _wire->setWireTimeout(DHT20_WIRE_TIME_OUT, true);
   return isConnected();
 }
@@ -40,7 +64,11 @@ bool DHT20::begin()
 #if defined(ESP8266) || defined(ESP32)
 bool DHT20::begin(const uint8_t dataPin, const uint8_t clockPin)
 {
-  if ((dataPin < 255) && (clockPin < 255))
+  if (_transfer != NULL)
+  {
+    //  bus is owned by the transfer hook
+  }
+  else if ((dataPin < 255) && (clockPin < 255))
   {
     _wire->begin(dataPin, clockPin);
   } else {
@@ -54,8 +82,7 @@ bool DHT20::begin(const uint8_t dataPin, const uint8_t clockPin)
 
 bool DHT20::isConnected()
 {
-  _wire->beginTransmission(DHT20_ADDRESS);
-  int rv = _wire->endTransmission();
+  int rv = _write(NULL, 0);
   return rv == 0;
 }
 
@@ -66,6 +93,13 @@ uint8_t DHT20::getAddress()
 }
 
 
+void DHT20::setTransfer(DHT20_TransferFn transfer, void *ctx)
+{
+  _transfer    = transfer;
+  _transferCtx = ctx;
+}
+
+
 //  See datasheet 7.4 Sensor Reading Process, point 1
 //  use with care.
 uint8_t DHT20::resetSensor()
@@ -95,44 +129,107 @@ int DHT20::read()
     return DHT20_ERROR_LASTREAD;
   }
 
-  int status = requestData();
-  if (status < 0) return status;
-  //  wait for measurement ready
-  while (isMeasuring())
+  int status = startConversion();
+  if (status != 0) return status;
+
+  //  sleep through the conversion instead of polling the status register
+  delay(DHT20_CONVERSION_TIME);
+  while (true)
   {
-    yield();
+    while (!poll())
+    {
+      delay(1);
+    }
+    status = collect();
+    if (status != DHT20_ERROR_BUSY) return status;
   }
-  //  read the measurement
-  status = readData();
-  if (status < 0) return status;
-
-  //  convert it to meaningful data
-  return convert();
 }
 
 
 int DHT20::requestData()
 {
-  //  reset sensor if needed.
-  resetSensor();
+  return startConversion();
+}
+
+
+////////////////////////////////////////////////
+//
+//  NON-BLOCKING READ
+//
+int DHT20::startConversion()
+{
+  //  the status byte of every measurement tells if calibration is still OK,
+  //  so the register check only runs until the first good read or after the sensor lost it.
+  if ((_status & 0x18) != 0x18)
+  {
+    resetSensor();
+  }
 
   //  GET CONNECTION
-  _wire->beginTransmission(DHT20_ADDRESS);
-  _wire->write(0xAC);
-  _wire->write(0x33);
-  _wire->write(0x00);
-  int rv = _wire->endTransmission();
+  const uint8_t trigger[3] = { 0xAC, 0x33, 0x00 };
+  int rv = _write(trigger, 3);
 
   _lastRequest = millis();
+  if (rv != 0)
+  {
+    _converting = false;
+    return rv;
+  }
+  _converting = true;
+  _armTimer(DHT20_CONVERSION_TIME);
   return rv;
 }
 
 
+bool DHT20::poll()
+{
+  if (!_converting) return false;
+#if defined(ESP32)
+  if (_timer != NULL) return _ready;
+#endif
+  return (int32_t)(millis() - _readyAt) >= 0;
+}
+
+
+int DHT20::collect()
+{
+  if (!_converting) return DHT20_ERROR_NOT_STARTED;
+
+  int status = readData();
+  if (status < 0)
+  {
+    _converting = false;
+    return status;
+  }
+  //  bit 7 of the status byte: still measuring, try again a bit later
+  if (_bits[0] & 0x80)
+  {
+    _armTimer(DHT20_CONVERSION_RETRY);
+    return DHT20_ERROR_BUSY;
+  }
+  _converting = false;
+  return convert();
+}
+
+
+bool DHT20::isConverting()
+{
+  return _converting;
+}
+
+
+void DHT20::setReadyCallback(DHT20_ReadyCallback callback, void *arg)
+{
+  _callback    = callback;
+  _callbackArg = arg;
+}
+
+
 int DHT20::readData()
 {
   //  GET DATA
   const uint8_t length = 7;
-  int bytes = _wire->requestFrom(DHT20_ADDRESS, length);
+  int bytes = _read(_bits, length);
 
   if (bytes == 0)     return DHT20_ERROR_CONNECT;
   if (bytes < length) return DHT20_MISSING_BYTES;
@@ -140,7 +237,6 @@ int DHT20::readData()
   bool allZero = true;
   for (int i = 0; i < bytes; i++)
   {
-    _bits[i] = _wire->read();
     //  if (_bits[i] < 0x10) Serial.print(0);
     //  Serial.print(_bits[i], HEX);
     //  Serial.print(" ");
@@ -229,9 +325,10 @@ float DHT20::getTempOffset()
 //
 uint8_t DHT20::readStatus()
 {
-  _wire->requestFrom(DHT20_ADDRESS, (uint8_t)1);
+  uint8_t status = 0;
+  _read(&status, 1);
   delay(1);  //  needed to stabilize timing
-  return (uint8_t) _wire->read();
+  return status;
 }
 
 
@@ -302,6 +399,46 @@ uint8_t DHT20::_crc8(uint8_t *ptr, uint8_t len)
 }
 
 
+void DHT20::_armTimer(uint32_t ms)
+{
+  _ready   = false;
+  _readyAt = millis() + ms;
+#if defined(ESP32)
+  if (_timer == NULL)
+  {
+    esp_timer_create_args_t args = {};
+    args.callback = &DHT20::_timerCallback;
+    args.arg      = this;
+    args.name     = "dht20";
+    if (esp_timer_create(&args, &_timer) != ESP_OK)
+    {
+      _timer = NULL;
+    }
+  }
+  if (_timer != NULL)
+  {
+    esp_timer_stop(_timer);
+    if (esp_timer_start_once(_timer, (uint64_t)ms * 1000) != ESP_OK)
+    {
+      //  fall back to the millis() deadline in poll()
+      esp_timer_delete(_timer);
+      _timer = NULL;
+    }
+  }
+#endif
+}
+
+
+#if defined(ESP32)
+void DHT20::_timerCallback(void *arg)
+{
+  DHT20 *self = (DHT20 *)arg;
+  self->_ready = true;
+  if (self->_callback != NULL) self->_callback(self->_callbackArg);
+}
+#endif
+
+
 //  Code based on demo code sent by www.aosong.com
 //  no further documentation.
 //  0x1B returned 18, 0, 4
@@ -311,31 +448,52 @@ uint8_t DHT20::_crc8(uint8_t *ptr, uint8_t len)
 //    other values unknown.
 bool DHT20::_resetRegister(uint8_t reg)
 {
-  uint8_t value[3];
-  _wire->beginTransmission(DHT20_ADDRESS);
-  _wire->write(reg);
-  _wire->write(0x00);
-  _wire->write(0x00);
-  if (_wire->endTransmission() != 0) return false;
+  uint8_t value[3] = { 0, 0, 0 };
+  const uint8_t request[3] = { reg, 0x00, 0x00 };
+  if (_write(request, 3) != 0) return false;
   delay(5);
 
-  int bytes = _wire->requestFrom(DHT20_ADDRESS, (uint8_t)3);
-  for (int i = 0; i < bytes; i++)
-  {
-    value[i] = _wire->read();
-    //  Serial.println(value[i], HEX);
-  }
+  _read(value, 3);
   delay(10);
 
-  _wire->beginTransmission(DHT20_ADDRESS);
-  _wire->write(0xB0 | reg);
-  _wire->write(value[1]);
-  _wire->write(value[2]);
-  if (_wire->endTransmission() != 0) return false;
+  const uint8_t restore[3] = { (uint8_t)(0xB0 | reg), value[1], value[2] };
+  if (_write(restore, 3) != 0) return false;
   delay(5);
   return true;
 }
 
 
+//  returns 0 on success, like TwoWire::endTransmission()
+int DHT20::_write(const uint8_t *data, uint8_t length)
+{
+  if (_transfer != NULL)
+  {
+    return _transfer(DHT20_ADDRESS, data, length, NULL, 0, _transferCtx);
+  }
+  _wire->beginTransmission(DHT20_ADDRESS);
+  for (uint8_t i = 0; i < length; i++)
+  {
+    _wire->write(data[i]);
+  }
+  return _wire->endTransmission();
+}
+
+
+//  returns the number of bytes read
+int DHT20::_read(uint8_t *data, uint8_t length)
+{
+  if (_transfer != NULL)
+  {
+    return (_transfer(DHT20_ADDRESS, NULL, 0, data, length, _transferCtx) == 0) ? length : 0;
+  }
+  int bytes = _wire->requestFrom(DHT20_ADDRESS, length);
+  for (int i = 0; i < bytes; i++)
+  {
+    data[i] = _wire->read();
+  }
+  return bytes;
+}
+
+
 // -- END OF FILE --
 
@@ -19,6 +19,9 @@
 
 #include "Arduino.h"
 #include "Wire.h"
+#if defined(ESP32)
+#include "esp_timer.h"
+#endif
 
 #define DHT20_LIB_VERSION                    (F("0.2.2"))
 
@@ -29,6 +32,24 @@
 #define DHT20_ERROR_BYTES_ALL_ZERO          -13
 #define DHT20_ERROR_READ_TIMEOUT            -14
 #define DHT20_ERROR_LASTREAD                -15
+#define DHT20_ERROR_BUSY                    -16
+#define DHT20_ERROR_NOT_STARTED             -17
+
+//  datasheet 7.4: wait 80 ms after the trigger before reading
+#define DHT20_CONVERSION_TIME               80
+//  extra wait when the sensor still reports busy at collect()
+#define DHT20_CONVERSION_RETRY              10
+
+
+//  callback when a started conversion is expected to be ready (ESP32 only).
+//  it runs in the esp_timer task: only set a flag or notify a task,
+//  do not touch the I2C bus from it.
+typedef void (*DHT20_ReadyCallback)(void *arg);
+
+
+//  optional bus transport replacing the direct TwoWire calls, e.g. a shared bus task.
+//  writes txLen bytes (txLen may be 0), then reads rxLen bytes; returns 0 on success.
+typedef int (*DHT20_TransferFn)(uint8_t address, const uint8_t *tx, uint8_t txLen, uint8_t *rx, uint8_t rxLen, void *ctx);
 
 
 class DHT20
@@ -37,6 +58,7 @@ public:
   //  CONSTRUCTOR
   //  fixed address 0x38
   DHT20(TwoWire *wire = &Wire);
+  ~DHT20();
 
   //  start the I2C
 #if defined(ESP8266) || defined(ESP32)
@@ -45,10 +67,23 @@ public:
   bool     begin();
   bool     isConnected();
   uint8_t  getAddress();
+  //  route all I2C traffic through transfer, NULL restores TwoWire.
+  void     setTransfer(DHT20_TransferFn transfer, void *ctx = NULL);
+
+
+  //  NON-BLOCKING CALL
+  //  startConversion() triggers the measurement and arms a one-shot timer,
+  //  poll() tells if the conversion time has passed (no I2C traffic),
+  //  collect() reads + converts the result.
+  int      startConversion();
+  bool     poll();
+  int      collect();
+  bool     isConverting();
+  void     setReadyCallback(DHT20_ReadyCallback callback, void *arg = NULL);
 
 
   //  ASYNCHRONUOUS CALL
-  //  trigger acquisition.
+  //  trigger acquisition, same as startConversion().
   int      requestData();
   //  read the raw data.
   int      readData();
@@ -108,12 +143,30 @@ private:
   uint32_t _lastRead;
   uint8_t  _bits[7];
 
+  //  conversion state
+  bool     _converting;
+  uint32_t _readyAt;
+  volatile bool _ready;
+  DHT20_ReadyCallback _callback;
+  void     *_callbackArg;
+#if defined(ESP32)
+  esp_timer_handle_t _timer;
+  static void _timerCallback(void *arg);
+#endif
+  void     _armTimer(uint32_t ms);
+
   uint8_t  _crc8(uint8_t *ptr, uint8_t len);
 
   //  use with care
   bool     _resetRegister(uint8_t reg);
 
+  //  bus access, through _transfer if set
+  int      _write(const uint8_t *data, uint8_t length);
+  int      _read(uint8_t *data, uint8_t length);
+
   TwoWire* _wire;
+  DHT20_TransferFn _transfer;
+  void     *_transferCtx;
 };
 
 
@@ -29,10 +29,29 @@ LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t lcd_addr, uint8_t lcd_cols, uint8_t
 	_rows = lcd_rows;
 	_charsize = charsize;
 	_backlightval = LCD_BACKLIGHT;
+	_transfer = NULL;
+	_transferCtx = NULL;
+	_fbEnabled = false;
+	_fbSynced = false;
+	_fbCol = 0;
+	_fbRow = 0;
+	_hwCol = -1;
+	_hwRow = -1;
+	memset(_fb, ' ', sizeof(_fb));
+	_burstActive = false;
+	_burstLen = 0;
+	_expanderState = Rw;	// never written by us, forces a setup byte on the first burst
+}
+
+void LiquidCrystal_I2C::setTransfer(LCD_TransferFn transfer, void *ctx) {
+	_transfer = transfer;
+	_transferCtx = ctx;
 }
 
 void LiquidCrystal_I2C::begin() {
-	Wire.begin();
+	if (_transfer == NULL) {
+		Wire.begin();
+	}
 	_displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
 
 	if (_rows > 1) {
@@ -79,8 +98,13 @@ void LiquidCrystal_I2C::begin() {
 	_displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
 	display();
 
-	// clear it off
-	clear();
+	// clear it off, on the display itself even in framebuffer mode
+	command(LCD_CLEARDISPLAY);
+	delayMicroseconds(2000);
+	memset(_shown, ' ', sizeof(_shown));
+	_fbSynced = true;
+	_hwCol = 0;
+	_hwRow = 0;
 
 	// Initialize to default text direction (for roman languages)
 	_displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
@@ -93,21 +117,95 @@ void LiquidCrystal_I2C::begin() {
 
 /********** high level commands, for the user! */
 void LiquidCrystal_I2C::clear(){
+	if (_fbEnabled) {
+		memset(_fb, ' ', sizeof(_fb));
+		_fbCol = 0;
+		_fbRow = 0;
+		return;
+	}
 	command(LCD_CLEARDISPLAY);// clear display, set cursor position to zero
 	delayMicroseconds(2000);  // this command takes a long time!
 }
 
 void LiquidCrystal_I2C::home(){
+	if (_fbEnabled) {
+		_fbCol = 0;
+		_fbRow = 0;
+		return;
+	}
 	command(LCD_RETURNHOME);  // set cursor position to zero
 	delayMicroseconds(2000);  // this command takes a long time!
 }
 
 void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row){
-	int row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
 	if (row > _rows) {
 		row = _rows-1;    // we count rows starting w/0
 	}
+	if (_fbEnabled) {
+		_fbCol = col;
+		_fbRow = row;
+		return;
+	}
+	moveCursor(col, row);
+}
+
+void LiquidCrystal_I2C::moveCursor(uint8_t col, uint8_t row){
+	int row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
 	command(LCD_SETDDRAMADDR | (col + row_offsets[row]));
+	_hwCol = col;
+	_hwRow = row;
+}
+
+/********** framebuffer mode */
+void LiquidCrystal_I2C::enableFramebuffer(bool enable) {
+	if (enable && !_fbEnabled) {
+		// the display content is unknown, the first flush repaints every cell
+		_fbSynced = false;
+		_hwCol = -1;
+		_hwRow = -1;
+		_fbCol = 0;
+		_fbRow = 0;
+	}
+	_fbEnabled = enable && _cols <= LCD_FB_MAX_COLS && _rows <= LCD_FB_MAX_ROWS;
+}
+
+bool LiquidCrystal_I2C::isFramebufferEnabled() {
+	return _fbEnabled;
+}
+
+uint8_t LiquidCrystal_I2C::flush() {
+	if (!_fbEnabled) {
+		return 0;
+	}
+	uint8_t sent = 0;
+	burstBegin();
+	for (uint8_t row = 0; row < _rows; row++) {
+		for (uint8_t col = 0; col < _cols; col++) {
+			if (_fbSynced && _fb[row][col] == _shown[row][col]) {
+				continue;
+			}
+			// a cursor move costs one byte transfer, the same as rewriting one
+			// unchanged cell, so only jump over gaps of two cells or more
+			if (_hwRow == row && _hwCol >= 0 && col - _hwCol == 1) {
+				send(_fb[row][_hwCol], Rs);
+				_hwCol++;
+			} else if (_hwRow != row || _hwCol != col) {
+				moveCursor(col, row);
+			}
+			send(_fb[row][col], Rs);
+			_shown[row][col] = _fb[row][col];
+			_hwCol++;
+			sent++;
+		}
+	}
+	_fbSynced = true;
+
+	// keep a visible cursor where the caller left it
+	if ((_displaycontrol & (LCD_CURSORON | LCD_BLINKON)) && _fbCol < _cols && _fbRow < _rows) {
+		moveCursor(_fbCol, _fbRow);
+	}
+	burstEnd();
+	return sent;
 }
 
 // Turn the display on/off (quickly)
@@ -204,10 +302,34 @@ inline void LiquidCrystal_I2C::command(uint8_t value) {
 }
 
 inline size_t LiquidCrystal_I2C::write(uint8_t value) {
+	if (_fbEnabled) {
+		if (_fbCol < _cols && _fbRow < _rows) {
+			_fb[_fbRow][_fbCol] = value;
+		}
+		_fbCol++;
+		return 1;
+	}
 	send(value, Rs);
+	_hwCol = -1;
 	return 1;
 }
 
+size_t LiquidCrystal_I2C::write(const uint8_t *buffer, size_t size) {
+	if (_fbEnabled) {
+		for (size_t i = 0; i < size; i++) {
+			write(buffer[i]);
+		}
+		return size;
+	}
+	burstBegin();
+	for (size_t i = 0; i < size; i++) {
+		send(buffer[i], Rs);
+	}
+	burstEnd();
+	_hwCol = -1;
+	return size;
+}
+
 
 /************ low level data pushing commands **********/
 
@@ -215,6 +337,11 @@ inline size_t LiquidCrystal_I2C::write(uint8_t value) {
 void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode) {
 	uint8_t highnib=value&0xf0;
 	uint8_t lownib=(value<<4)&0xf0;
+	if (_burstActive) {
+		burst4bits((highnib)|mode);
+		burst4bits((lownib)|mode);
+		return;
+	}
 	write4bits((highnib)|mode);
 	write4bits((lownib)|mode);
 }
@@ -225,8 +352,14 @@ void LiquidCrystal_I2C::write4bits(uint8_t value) {
 }
 
 void LiquidCrystal_I2C::expanderWrite(uint8_t _data){
+	uint8_t value = _data | _backlightval;
+	_expanderState = value;
+	if (_transfer != NULL) {
+		_transfer(_addr, &value, 1, NULL, 0, _transferCtx);
+		return;
+	}
 	Wire.beginTransmission(_addr);
-	Wire.write((int)(_data) | _backlightval);
+	Wire.write((int)value);
 	Wire.endTransmission();
 }
 
@@ -238,6 +371,44 @@ void LiquidCrystal_I2C::pulseEnable(uint8_t _data){
 	delayMicroseconds(50);		// commands need > 37us to settle
 }
 
+// Only commands that finish within one character time (data, DDRAM address)
+// may be sent between burstBegin() and burstEnd().
+void LiquidCrystal_I2C::burstBegin() {
+	_burstActive = true;
+	_burstLen = 0;
+}
+
+void LiquidCrystal_I2C::burst4bits(uint8_t value) {
+	if (_burstLen + 3 > LCD_BURST_BYTES) {
+		burstEnd();
+		_burstActive = true;
+	}
+	uint8_t out = value | _backlightval;
+	// RS must settle before En rises; the data lines only have to be valid
+	// when En falls, so the setup byte is skipped while RS stays the same
+	if ((out ^ _expanderState) & (Rs | Rw)) {
+		_burst[_burstLen++] = out;
+	}
+	_burst[_burstLen++] = out | En;	// En high, at least one byte time > 450ns
+	_burst[_burstLen++] = out & ~En;	// En low, the next pulse is two byte times > 37us later
+	_expanderState = out & ~En;
+}
+
+void LiquidCrystal_I2C::burstEnd() {
+	_burstActive = false;
+	if (_burstLen == 0) {
+		return;
+	}
+	if (_transfer != NULL) {
+		_transfer(_addr, _burst, _burstLen, NULL, 0, _transferCtx);
+	} else {
+		Wire.beginTransmission(_addr);
+		Wire.write(_burst, _burstLen);
+		Wire.endTransmission();
+	}
+	_burstLen = 0;
+}
+
 void LiquidCrystal_I2C::load_custom_character(uint8_t char_num, uint8_t *rows){
 	createChar(char_num, rows);
 }
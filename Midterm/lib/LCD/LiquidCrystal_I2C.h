@@ -50,6 +50,21 @@
 #define Rw B00000010  // Read/Write bit
 #define Rs B00000001  // Register select bit
 
+// largest display the framebuffer mode supports
+#define LCD_FB_MAX_COLS 20
+#define LCD_FB_MAX_ROWS 4
+
+// bytes per I2C transaction when streaming characters, fits the 32 byte Wire buffer of every core
+#ifndef LCD_BURST_BYTES
+#define LCD_BURST_BYTES 32
+#endif
+
+/**
+ * Optional bus transport used instead of the global Wire object, e.g. a shared bus task.
+ * Writes txLen bytes, then reads rxLen bytes. Returns 0 on success.
+ */
+typedef int (*LCD_TransferFn)(uint8_t address, const uint8_t *tx, uint8_t txLen, uint8_t *rx, uint8_t rxLen, void *ctx);
+
 /**
  * This is the driver for the Liquid Crystal LCD displays that use the I2C bus.
  *
@@ -75,6 +90,30 @@ public:
 	 */
 	void begin();
 
+	/**
+	 * Send all I2C traffic through the given transfer function instead of Wire.
+	 * Call before begin(); the bus must then be started by whoever owns it. NULL restores Wire.
+	 */
+	void setTransfer(LCD_TransferFn transfer, void *ctx = NULL);
+
+	/**
+	 * Framebuffer mode: clear(), home(), setCursor() and print()/write() only draw into a copy of
+	 * the screen in RAM, nothing is sent until flush(). Other commands still go to the display
+	 * directly. Assumes the default left-to-right entry mode without scrolling.
+	 *
+	 * @param enable	true to draw into RAM, false to write straight to the display again.
+	 */
+	void enableFramebuffer(bool enable = true);
+	bool isFramebufferEnabled();
+
+	/**
+	 * Send the cells that differ from what the display currently shows, moving the cursor
+	 * only where skipping ahead is cheaper than rewriting. The first flush sends everything.
+	 *
+	 * @return	Number of characters sent.
+	 */
+	uint8_t flush();
+
 	 /**
 	  * Remove all the characters currently shown. Next print/write operation will start
 	  * from the first position on LCD display.
@@ -135,6 +174,13 @@ public:
 	void createChar(uint8_t, uint8_t[]);
 	void setCursor(uint8_t, uint8_t);
 	virtual size_t write(uint8_t);
+
+	/**
+	 * Write a string in bursts: the nibbles and enable pulses of several characters go out
+	 * in one I2C transaction instead of one transaction per expander state. The enable
+	 * timing then comes from the I2C byte time, which is long enough up to 400 kHz.
+	 */
+	virtual size_t write(const uint8_t *buffer, size_t size);
 	void command(uint8_t);
 
 	inline void blink_on() { blink(); }
@@ -152,6 +198,10 @@ private:
 	void write4bits(uint8_t);
 	void expanderWrite(uint8_t);
 	void pulseEnable(uint8_t);
+	void burstBegin();
+	void burst4bits(uint8_t);
+	void burstEnd();
+	void moveCursor(uint8_t, uint8_t);
 	uint8_t _addr;
 	uint8_t _displayfunction;
 	uint8_t _displaycontrol;
@@ -160,6 +210,24 @@ private:
 	uint8_t _rows;
 	uint8_t _charsize;
 	uint8_t _backlightval;
+	LCD_TransferFn _transfer;
+	void *_transferCtx;
+
+	// burst mode: send() queues expander states here, burstEnd() writes them out
+	bool _burstActive;
+	uint8_t _burstLen;
+	uint8_t _burst[LCD_BURST_BYTES];
+	uint8_t _expanderState;	// last byte written or queued to the PCF8574
+
+	// framebuffer mode: _fb is what the caller drew, _shown what the display holds
+	bool _fbEnabled;
+	bool _fbSynced;
+	uint8_t _fbCol;
+	uint8_t _fbRow;
+	int8_t _hwCol;		// display cursor position, -1 when unknown
+	int8_t _hwRow;
+	uint8_t _fb[LCD_FB_MAX_ROWS][LCD_FB_MAX_COLS];
+	uint8_t _shown[LCD_FB_MAX_ROWS][LCD_FB_MAX_COLS];
 };
 
 #endif // FDB_LIQUID_CRYSTAL_I2C_H
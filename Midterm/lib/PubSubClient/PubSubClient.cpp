@@ -160,6 +160,9 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGN
 
 PubSubClient::~PubSubClient() {
   free(this->buffer);
+  for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+    free(this->inflight[i].packet);
+  }
 }
 
 boolean PubSubClient::connect(const char *id) {
@@ -270,6 +273,13 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
                     lastInActivity = millis();
                     pingOutstanding = false;
                     _state = MQTT_CONNECTED;
+                    // Whatever was not acknowledged on the previous connection goes out again
+                    for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+                        if (this->inflight[i].packet != NULL) {
+                            this->inflight[i].retries = 0;
+                            sendInflight(&this->inflight[i], true);
+                        }
+                    }
                     return true;
                 } else {
                     _state = buffer[3];
@@ -298,28 +308,42 @@ boolean PubSubClient::readByte(uint8_t * result) {
    return true;
 }
 
-// reads a byte into result[*index] and increments index
-boolean PubSubClient::readByte(uint8_t * result, uint16_t * index){
-  uint16_t current_index = *index;
-  uint8_t * write_address = &(result[current_index]);
-  if(readByte(write_address)){
-    *index = current_index + 1;
-    return true;
-  }
-  return false;
+// reads length bytes into result, taking as many as the client has available with each read
+boolean PubSubClient::readBytes(uint8_t * result, uint32_t length) {
+   uint32_t previousMillis = millis();
+   while (length > 0) {
+     int available = _client->available();
+     if (available <= 0) {
+       yield();
+       uint32_t currentMillis = millis();
+       if(currentMillis - previousMillis >= ((int32_t) this->socketTimeout * 1000)){
+         return false;
+       }
+       continue;
+     }
+     int count = _client->read(result, (uint32_t)available < length ? available : length);
+     if (count <= 0) {
+       return false;
+     }
+     result += count;
+     length -= count;
+     previousMillis = millis();
+   }
+   return true;
 }
 
 uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
-    uint16_t len = 0;
-    if(!readByte(this->buffer, &len)) return 0;
+    // Every packet has at least the fixed header and one remaining length byte
+    if(!readBytes(this->buffer, 2)) return 0;
+    uint16_t len = 2;
     bool isPublish = (this->buffer[0]&0xF0) == MQTTPUBLISH;
-    uint32_t multiplier = 1;
-    uint32_t length = 0;
-    uint8_t digit = 0;
+    uint8_t digit = this->buffer[1];
+    uint32_t multiplier = 128;
+    uint32_t length = digit & 127;
     uint16_t skip = 0;
     uint32_t start = 0;
 
-    do {
+    while ((digit & 128) != 0) {
         if (len == 5) {
             // Invalid remaining length encoding - kill the connection
             _state = MQTT_DISCONNECTED;
@@ -330,13 +354,13 @@ uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
         this->buffer[len++] = digit;
         length += (digit & 127) * multiplier;
         multiplier <<=7; //multiplier *= 128
-    } while ((digit & 128) != 0);
+    }
     *lengthLength = len-1;
 
     if (isPublish) {
         // Read in topic length to calculate bytes to skip over for Stream writing
-        if(!readByte(this->buffer, &len)) return 0;
-        if(!readByte(this->buffer, &len)) return 0;
+        if(!readBytes(this->buffer+len, 2)) return 0;
+        len += 2;
         skip = (this->buffer[*lengthLength+1]<<8)+this->buffer[*lengthLength+2];
         start = 2;
         if (this->buffer[0]&MQTTQOS1) {
@@ -345,20 +369,29 @@ uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
         }
     }
     uint32_t idx = len;
-
-    for (uint32_t i = start;i<length;i++) {
-        if(!readByte(&digit)) return 0;
-        if (this->stream) {
-            if (isPublish && idx-*lengthLength-2>skip) {
-                this->stream->write(digit);
-            }
-        }
-
+    // Index of the first payload byte within the packet, everything from there on goes to the stream
+    uint32_t payloadStart = *lengthLength + 3 + skip;
+    uint32_t remaining = length > start ? length - start : 0;
+    uint8_t overflow[64];
+
+    // The rest of the packet in bulk, straight into the buffer while it has room
+    while (remaining > 0) {
+        uint8_t* target = overflow;
+        uint32_t count = remaining < sizeof(overflow) ? remaining : sizeof(overflow);
         if (len < this->bufferSize) {
-            this->buffer[len] = digit;
-            len++;
+            target = this->buffer + len;
+            count = remaining < (uint32_t)(this->bufferSize - len) ? remaining : this->bufferSize - len;
+        }
+        if(!readBytes(target, count)) return 0;
+        if (this->stream && isPublish && idx + count > payloadStart) {
+            uint32_t offset = idx < payloadStart ? payloadStart - idx : 0;
+            this->stream->write(target + offset, count - offset);
         }
-        idx++;
+        if (target != overflow) {
+            len += count;
+        }
+        idx += count;
+        remaining -= count;
     }
 
     if (!this->stream && idx > this->bufferSize) {
@@ -416,6 +449,16 @@ boolean PubSubClient::loop() {
                             callback(topic,payload,len-llen-3-tl);
                         }
                     }
+                } else if (type == MQTTPUBACK) {
+                    if (len == 4) {
+                        msgId = (this->buffer[2]<<8)+this->buffer[3];
+                        for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+                            if (this->inflight[i].packet != NULL && this->inflight[i].msgId == msgId) {
+                                releaseInflight(&this->inflight[i], true);
+                                break;
+                            }
+                        }
+                    }
                 } else if (type == MQTTPINGREQ) {
                     this->buffer[0] = MQTTPINGRESP;
                     this->buffer[1] = 0;
@@ -428,6 +471,9 @@ boolean PubSubClient::loop() {
                 return false;
             }
         }
+        if (this->inflightCount > 0) {
+            retryInflight(t);
+        }
         return true;
     }
     return false;
@@ -471,6 +517,123 @@ boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigne
     return false;
 }
 
+boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained, uint8_t qos, uint16_t* msgId) {
+    if (qos == 0) {
+        return publish(topic, payload, plength, retained);
+    }
+    if (qos > 1 || !connected() || this->inflightCount >= this->inflightWindow) {
+        return false;
+    }
+    MQTTInflight* slot = NULL;
+    for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+        if (this->inflight[i].packet == NULL) {
+            slot = &this->inflight[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        return false;
+    }
+    size_t tlen = strnlen(topic, this->bufferSize);
+    uint32_t remaining = 2 + tlen + 2 + plength;
+    // Largest remaining length four length bytes can encode
+    if (remaining > 268435455UL) {
+        return false;
+    }
+    uint8_t* packet = (uint8_t*)malloc(MQTT_MAX_HEADER_SIZE + remaining);
+    if (packet == NULL) {
+        return false;
+    }
+    uint16_t id = nextPacketId();
+    uint32_t length = writeString(topic,packet,MQTT_MAX_HEADER_SIZE);
+    packet[length++] = (id >> 8);
+    packet[length++] = (id & 0xFF);
+    if (plength > 0) {
+        memcpy(packet+length, payload, plength);
+    }
+
+    uint8_t header = MQTTPUBLISH|MQTTQOS1;
+    if (retained) {
+        header |= 1;
+    }
+    // Move the packet to the start of the allocation, so a retransmission is a single write
+    size_t hlen = buildHeader(header, packet, remaining);
+    memmove(packet, packet+(MQTT_MAX_HEADER_SIZE-hlen), hlen+remaining);
+
+    slot->packet = packet;
+    slot->length = hlen+remaining;
+    slot->msgId = id;
+    slot->retries = 0;
+    this->inflightCount++;
+    if (!sendInflight(slot, false)) {
+        free(slot->packet);
+        slot->packet = NULL;
+        this->inflightCount--;
+        return false;
+    }
+    if (msgId != NULL) {
+        *msgId = id;
+    }
+    return true;
+}
+
+uint8_t PubSubClient::getInflightCount() {
+    return this->inflightCount;
+}
+
+uint16_t PubSubClient::nextPacketId() {
+    // Skip 0 and ids still waiting for their acknowledgement
+    boolean used;
+    do {
+        nextMsgId++;
+        if (nextMsgId == 0) {
+            nextMsgId = 1;
+        }
+        used = false;
+        for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+            if (this->inflight[i].packet != NULL && this->inflight[i].msgId == nextMsgId) {
+                used = true;
+                break;
+            }
+        }
+    } while (used);
+    return nextMsgId;
+}
+
+boolean PubSubClient::sendInflight(MQTTInflight* slot, boolean dup) {
+    if (dup) {
+        slot->packet[0] |= MQTTDUP;
+    }
+    boolean result = writePacket(slot->packet, slot->length);
+    slot->sentAt = millis();
+    return result;
+}
+
+void PubSubClient::releaseInflight(MQTTInflight* slot, boolean delivered) {
+    uint16_t id = slot->msgId;
+    free(slot->packet);
+    slot->packet = NULL;
+    this->inflightCount--;
+    if (publishCallback) {
+        publishCallback(id, delivered);
+    }
+}
+
+void PubSubClient::retryInflight(unsigned long t) {
+    for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+        MQTTInflight* slot = &this->inflight[i];
+        if (slot->packet == NULL || t - slot->sentAt < this->retryTimeout) {
+            continue;
+        }
+        if (this->maxRetries != 0 && slot->retries >= this->maxRetries) {
+            releaseInflight(slot, false);
+            continue;
+        }
+        slot->retries++;
+        sendInflight(slot, true);
+    }
+}
+
 boolean PubSubClient::publish_P(const char* topic, const char* payload, boolean retained) {
     return publish_P(topic, (const uint8_t*)payload, payload ? strnlen(payload, this->bufferSize) : 0, retained);
 }
@@ -540,6 +703,78 @@ boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, bool
     return false;
 }
 
+uint8_t* PubSubClient::beginPublishBuffer(const char* topic, uint16_t* capacity) {
+    if (!connected() || topic == NULL) {
+        return NULL;
+    }
+    size_t tlen = strnlen(topic, this->bufferSize);
+    if (this->bufferSize <= MQTT_MAX_HEADER_SIZE + 2 + tlen) {
+        return NULL;
+    }
+    uint16_t length = writeString(topic,this->buffer,MQTT_MAX_HEADER_SIZE);
+    *capacity = this->bufferSize - length;
+    return this->buffer + length;
+}
+
+boolean PubSubClient::endPublishBuffer(unsigned int plength, boolean retained) {
+    // The topic length written by beginPublishBuffer tells where the payload starts
+    uint16_t length = MQTT_MAX_HEADER_SIZE + 2 + ((this->buffer[MQTT_MAX_HEADER_SIZE] << 8) | this->buffer[MQTT_MAX_HEADER_SIZE+1]);
+    if (!connected() || length + plength > this->bufferSize) {
+        return false;
+    }
+    uint8_t header = MQTTPUBLISH;
+    if (retained) {
+        header |= 1;
+    }
+    return write(header,this->buffer,length+plength-MQTT_MAX_HEADER_SIZE);
+}
+
+boolean PubSubClient::publishSegments(const char* topic, const uint8_t* const* segments, const size_t* lengths, size_t count, boolean retained) {
+    if (!connected()) {
+        return false;
+    }
+    size_t tlen = strnlen(topic, this->bufferSize);
+    if (this->bufferSize < MQTT_MAX_HEADER_SIZE + 2 + tlen) {
+        return false;
+    }
+    uint32_t plength = 0;
+    for (size_t i = 0; i < count; i++) {
+        plength += lengths[i];
+    }
+    // Largest remaining length four length bytes can encode
+    if (plength > 268435455UL - 2 - tlen) {
+        return false;
+    }
+
+    uint16_t used = writeString(topic,this->buffer,MQTT_MAX_HEADER_SIZE);
+    uint8_t header = MQTTPUBLISH;
+    if (retained) {
+        header |= 1;
+    }
+    size_t hlen = buildHeader(header, this->buffer, plength+used-MQTT_MAX_HEADER_SIZE);
+    uint16_t from = MQTT_MAX_HEADER_SIZE-hlen;
+    boolean result = true;
+
+    // Every write goes through writePacket(), so MQTT_MAX_TRANSFER_SIZE is honoured for the gathered parts and the large segments alike
+    for (size_t i = 0; i < count && result; i++) {
+        if (lengths[i] <= MQTT_MAX_GATHER_SIZE && used + lengths[i] <= this->bufferSize) {
+            memcpy(this->buffer+used, segments[i], lengths[i]);
+            used += lengths[i];
+            continue;
+        }
+        // Send what has been gathered so far, then the segment straight from the caller
+        if (used > from) {
+            result = writePacket(this->buffer+from, used-from);
+        }
+        from = used = 0;
+        result = result && writePacket(segments[i], lengths[i]);
+    }
+    if (result && used > from) {
+        result = writePacket(this->buffer+from, used-from);
+    }
+    return result;
+}
+
 int PubSubClient::endPublish() {
  return 1;
 }
@@ -554,12 +789,12 @@ size_t PubSubClient::write(const uint8_t *buffer, size_t size) {
     return _client->write(buffer,size);
 }
 
-size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint16_t length) {
+size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint32_t length) {
     uint8_t lenBuf[4];
     uint8_t llen = 0;
     uint8_t digit;
     uint8_t pos = 0;
-    uint16_t len = length;
+    uint32_t len = length;
     do {
 
         digit = len  & 127; //digit = len %128
@@ -579,13 +814,16 @@ size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint16_t length)
 }
 
 boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
-    uint16_t rc;
     uint8_t hlen = buildHeader(header, buf, length);
+    return writePacket(buf+(MQTT_MAX_HEADER_SIZE-hlen), length+hlen);
+}
 
+boolean PubSubClient::writePacket(const uint8_t* packet, uint32_t length) {
 #ifdef MQTT_MAX_TRANSFER_SIZE
-    uint8_t* writeBuf = buf+(MQTT_MAX_HEADER_SIZE-hlen);
-    uint16_t bytesRemaining = length+hlen;  //Match the length type
-    uint8_t bytesToWrite;
+    const uint8_t* writeBuf = packet;
+    uint32_t bytesRemaining = length;
+    uint32_t bytesToWrite;
+    size_t rc;
     boolean result = true;
     while((bytesRemaining > 0) && result) {
         bytesToWrite = (bytesRemaining > MQTT_MAX_TRANSFER_SIZE)?MQTT_MAX_TRANSFER_SIZE:bytesRemaining;
@@ -594,11 +832,12 @@ boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
         bytesRemaining -= rc;
         writeBuf += rc;
     }
+    lastOutActivity = millis();
     return result;
 #else
-    rc = _client->write(buf+(MQTT_MAX_HEADER_SIZE-hlen),length+hlen);
+    size_t rc = _client->write(packet,length);
     lastOutActivity = millis();
-    return (rc == hlen+length);
+    return (rc == length);
 #endif
 }
 
@@ -621,12 +860,9 @@ boolean PubSubClient::subscribe(const char* topic, uint8_t qos) {
     if (connected()) {
         // Leave room in the buffer for header and variable length field
         uint16_t length = MQTT_MAX_HEADER_SIZE;
-        nextMsgId++;
-        if (nextMsgId == 0) {
-            nextMsgId = 1;
-        }
-        this->buffer[length++] = (nextMsgId >> 8);
-        this->buffer[length++] = (nextMsgId & 0xFF);
+        uint16_t id = nextPacketId();
+        this->buffer[length++] = (id >> 8);
+        this->buffer[length++] = (id & 0xFF);
         length = writeString((char*)topic, this->buffer,length);
         this->buffer[length++] = qos;
         return write(MQTTSUBSCRIBE|MQTTQOS1,this->buffer,length-MQTT_MAX_HEADER_SIZE);
@@ -645,12 +881,9 @@ boolean PubSubClient::unsubscribe(const char* topic) {
     }
     if (connected()) {
         uint16_t length = MQTT_MAX_HEADER_SIZE;
-        nextMsgId++;
-        if (nextMsgId == 0) {
-            nextMsgId = 1;
-        }
-        this->buffer[length++] = (nextMsgId >> 8);
-        this->buffer[length++] = (nextMsgId & 0xFF);
+        uint16_t id = nextPacketId();
+        this->buffer[length++] = (id >> 8);
+        this->buffer[length++] = (id & 0xFF);
         length = writeString(topic, this->buffer,length);
         return write(MQTTUNSUBSCRIBE|MQTTQOS1,this->buffer,length-MQTT_MAX_HEADER_SIZE);
     }
@@ -723,6 +956,27 @@ PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
     return *this;
 }
 
+PubSubClient& PubSubClient::setPublishCallback(MQTT_PUBLISH_CALLBACK_SIGNATURE) {
+    this->publishCallback = publishCallback;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setInflightWindow(uint8_t window) {
+    if (window == 0) {
+        window = 1;
+    } else if (window > MQTT_MAX_INFLIGHT) {
+        window = MQTT_MAX_INFLIGHT;
+    }
+    this->inflightWindow = window;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setRetry(uint16_t timeout, uint8_t retries) {
+    this->retryTimeout = timeout;
+    this->maxRetries = retries;
+    return *this;
+}
+
 PubSubClient& PubSubClient::setClient(Client& client){
     this->_client = &client;
     return *this;
@@ -36,6 +36,30 @@
 #define MQTT_SOCKET_TIMEOUT 15
 #endif
 
+// MQTT_MAX_GATHER_SIZE : payload segments up to this size are copied next to the
+//  topic in publishSegments() and sent with it, bigger ones are written on their own
+#ifndef MQTT_MAX_GATHER_SIZE
+#define MQTT_MAX_GATHER_SIZE 64
+#endif
+
+// MQTT_MAX_INFLIGHT : most QoS 1 publishes waiting for their PUBACK at the same time.
+//  Override the window with setInflightWindow(), up to this many
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 8
+#endif
+
+// MQTT_RETRY_TIMEOUT : milliseconds without PUBACK after which a QoS 1 publish is sent
+//  again with the DUP flag set. Override with setRetry()
+#ifndef MQTT_RETRY_TIMEOUT
+#define MQTT_RETRY_TIMEOUT 5000
+#endif
+
+// MQTT_MAX_RETRIES : retransmissions on one connection before a QoS 1 publish is given
+//  up and reported as not delivered, 0 retries until acknowledged. Override with setRetry()
+#ifndef MQTT_MAX_RETRIES
+#define MQTT_MAX_RETRIES 3
+#endif
+
 // MQTT_MAX_TRANSFER_SIZE : limit how much data is passed to the network client
 //  in each write call. Needed for the Arduino Wifi Shield. Leave undefined to
 //  pass the entire MQTT packet in each write call.
@@ -72,6 +96,7 @@
 #define MQTTQOS0        (0 << 1)
 #define MQTTQOS1        (1 << 1)
 #define MQTTQOS2        (2 << 1)
+#define MQTTDUP         (1 << 3)
 
 // Maximum size of fixed header and variable length size header
 #define MQTT_MAX_HEADER_SIZE 5
@@ -79,10 +104,21 @@
 #if defined(ESP8266) || defined(ESP32)
 #include <functional>
 #define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+#define MQTT_PUBLISH_CALLBACK_SIGNATURE std::function<void(uint16_t, boolean)> publishCallback
 #else
 #define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
+#define MQTT_PUBLISH_CALLBACK_SIGNATURE void (*publishCallback)(uint16_t, boolean)
 #endif
 
+// A QoS 1 publish waiting for its PUBACK
+typedef struct {
+    uint8_t* packet;        // the whole PUBLISH packet as sent, NULL if the slot is free
+    uint32_t length;
+    uint16_t msgId;
+    uint8_t retries;
+    unsigned long sentAt;
+} MQTTInflight;
+
 #define CHECK_STRING_LENGTH(l,s) if (l+2+strnlen(s, this->bufferSize) > this->bufferSize) {_client->stop();return false;}
 
 class PubSubClient : public Print {
@@ -97,16 +133,28 @@ private:
    unsigned long lastInActivity;
    bool pingOutstanding;
    MQTT_CALLBACK_SIGNATURE;
+   MQTT_PUBLISH_CALLBACK_SIGNATURE = NULL;
+   MQTTInflight inflight[MQTT_MAX_INFLIGHT] = {};
+   uint8_t inflightWindow = MQTT_MAX_INFLIGHT;
+   uint8_t inflightCount = 0;
+   uint16_t retryTimeout = MQTT_RETRY_TIMEOUT;
+   uint8_t maxRetries = MQTT_MAX_RETRIES;
+   uint16_t nextPacketId();
+   boolean sendInflight(MQTTInflight* slot, boolean dup);
+   void releaseInflight(MQTTInflight* slot, boolean delivered);
+   void retryInflight(unsigned long t);
    uint32_t readPacket(uint8_t*);
    boolean readByte(uint8_t * result);
-   boolean readByte(uint8_t * result, uint16_t * index);
+   boolean readBytes(uint8_t * result, uint32_t length);
    boolean write(uint8_t header, uint8_t* buf, uint16_t length);
+   // Sends a complete packet, in pieces of at most MQTT_MAX_TRANSFER_SIZE if that is defined
+   boolean writePacket(const uint8_t* packet, uint32_t length);
    uint16_t writeString(const char* string, uint8_t* buf, uint16_t pos);
    // Build up the header ready to send
    // Returns the size of the header
    // Note: the header is built at the end of the first MQTT_MAX_HEADER_SIZE bytes, so will start
    //       (MQTT_MAX_HEADER_SIZE - <returned size>) bytes into the buffer
-   size_t buildHeader(uint8_t header, uint8_t* buf, uint16_t length);
+   size_t buildHeader(uint8_t header, uint8_t* buf, uint32_t length);
    IPAddress ip;
    const char* domain;
    uint16_t port;
@@ -138,6 +186,15 @@ public:
    PubSubClient& setStream(Stream& stream);
    PubSubClient& setKeepAlive(uint16_t keepAlive);
    PubSubClient& setSocketTimeout(uint16_t timeout);
+   // Called with the message id of every QoS 1 publish once it is acknowledged by the broker
+   // (true) or given up after the configured retries (false)
+   PubSubClient& setPublishCallback(MQTT_PUBLISH_CALLBACK_SIGNATURE);
+   // Most QoS 1 publishes waiting for their PUBACK at once, 1 up to MQTT_MAX_INFLIGHT
+   // Messages already in flight stay there, the new window applies to following publishes
+   PubSubClient& setInflightWindow(uint8_t window);
+   // Milliseconds before an unacknowledged QoS 1 publish is sent again, and how often
+   // that is done before it is given up, 0 never gives up while connected
+   PubSubClient& setRetry(uint16_t timeout, uint8_t retries);
 
    boolean setBufferSize(uint16_t size);
    uint16_t getBufferSize();
@@ -152,6 +209,14 @@ public:
    boolean publish(const char* topic, const char* payload, boolean retained);
    boolean publish(const char* topic, const uint8_t * payload, unsigned int plength);
    boolean publish(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained);
+   // Publish with the given QoS, 0 or 1. A QoS 1 message is copied and kept until the broker
+   // acknowledges it, up to the in flight window at once, and sent again with DUP set when
+   // the PUBACK does not arrive in time or after reconnecting. msgId, if given, receives the
+   // id the publish callback reports it with
+   // Returns 0 if not connected, the window is full or the copy could not be allocated
+   boolean publish(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained, uint8_t qos, uint16_t* msgId = NULL);
+   // QoS 1 publishes not acknowledged yet
+   uint8_t getInflightCount();
    boolean publish_P(const char* topic, const char* payload, boolean retained);
    boolean publish_P(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained);
    // Start to publish a message.
@@ -166,6 +231,23 @@ public:
    // Finish off this publish message (started with beginPublish)
    // Returns 1 if the packet was sent successfully, 0 if there was an error
    int endPublish();
+   // Start a publish whose payload is written directly into the internal buffer.
+   // This API:
+   //   beginPublishBuffer(...) returns where the payload goes, right after the space
+   //     reserved for the fixed header and the already written topic
+   //   the caller writes up to *capacity payload bytes there
+   //   endPublishBuffer(...) fills in the fixed header and sends the packet in one write
+   // Nothing else may use the client in between, incoming packets share the buffer
+   // Returns NULL if not connected or if the topic leaves no room for a payload
+   uint8_t* beginPublishBuffer(const char* topic, uint16_t* capacity);
+   // Send the publish started with beginPublishBuffer with the given payload length
+   // Returns 1 if the packet was sent successfully, 0 if there was an error
+   boolean endPublishBuffer(unsigned int plength, boolean retained);
+   // Publish a message whose payload is made of count segments, without assembling the payload
+   // in the internal buffer, so it is not limited by the buffer size. Header, topic and small
+   // segments are sent with one write, bigger segments are written from where they are
+   // Returns 1 if the packet was sent successfully, 0 if there was an error
+   boolean publishSegments(const char* topic, const uint8_t* const* segments, const size_t* lengths, size_t count, boolean retained);
    // Write a single byte of payload (only to be used with beginPublish/endPublish)
    virtual size_t write(uint8_t);
    // Write size bytes from buffer into the payload (only to be used with beginPublish/endPublish)
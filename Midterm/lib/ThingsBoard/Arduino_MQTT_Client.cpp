@@ -23,6 +23,10 @@ void Arduino_MQTT_Client::set_callback(function cb) {
     m_mqtt_client.setCallback(cb);
 }
 
+void Arduino_MQTT_Client::set_delivery_callback(delivery_function cb) {
+    m_mqtt_client.setPublishCallback(cb);
+}
+
 bool Arduino_MQTT_Client::set_buffer_size(const uint16_t& buffer_size) {
     return m_mqtt_client.setBufferSize(buffer_size);
 }
@@ -51,6 +55,14 @@ bool Arduino_MQTT_Client::publish(const char *topic, const uint8_t *payload, con
     return m_mqtt_client.publish(topic, payload, length, false);
 }
 
+bool Arduino_MQTT_Client::publish(const char *topic, const uint8_t *payload, const size_t& length, const uint8_t& qos, uint16_t *message_id) {
+    return m_mqtt_client.publish(topic, payload, length, false, qos, message_id);
+}
+
+bool Arduino_MQTT_Client::publish_segments(const char *topic, const uint8_t *const *segments, const size_t *lengths, const size_t& count) {
+    return m_mqtt_client.publishSegments(topic, segments, lengths, count, false);
+}
+
 bool Arduino_MQTT_Client::subscribe(const char *topic) {
     return m_mqtt_client.subscribe(topic);
 }
@@ -63,6 +75,17 @@ bool Arduino_MQTT_Client::connected() {
     return m_mqtt_client.connected();
 }
 
+uint8_t *Arduino_MQTT_Client::begin_buffered_publish(const char *topic, size_t& capacity) {
+    uint16_t available = 0U;
+    uint8_t *payload = m_mqtt_client.beginPublishBuffer(topic, &available);
+    capacity = available;
+    return payload;
+}
+
+bool Arduino_MQTT_Client::end_buffered_publish(const size_t& length) {
+    return m_mqtt_client.endPublishBuffer(length, false);
+}
+
 #if THINGSBOARD_ENABLE_STREAM_UTILS
 
 bool Arduino_MQTT_Client::begin_publish(const char *topic, const size_t& length) {
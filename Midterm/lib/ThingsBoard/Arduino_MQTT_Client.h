@@ -29,6 +29,8 @@ class Arduino_MQTT_Client : public IMQTT_Client {
 
     void set_callback(function cb) override;
 
+    void set_delivery_callback(delivery_function cb) override;
+
     bool set_buffer_size(const uint16_t& buffer_size) override;
 
     uint16_t get_buffer_size() override;
@@ -43,12 +45,20 @@ class Arduino_MQTT_Client : public IMQTT_Client {
 
     bool publish(const char *topic, const uint8_t *payload, const size_t& length) override;
 
+    bool publish(const char *topic, const uint8_t *payload, const size_t& length, const uint8_t& qos, uint16_t *message_id) override;
+
+    bool publish_segments(const char *topic, const uint8_t *const *segments, const size_t *lengths, const size_t& count) override;
+
     bool subscribe(const char *topic) override;
 
     bool unsubscribe(const char *topic) override;
 
     bool connected() override;
 
+    uint8_t *begin_buffered_publish(const char *topic, size_t& capacity) override;
+
+    bool end_buffered_publish(const size_t& length) override;
+
 #if THINGSBOARD_ENABLE_STREAM_UTILS
 
     bool begin_publish(const char *topic, const size_t& length) override;
@@ -115,6 +115,22 @@
 #    define THINGSBOARD_USE_ESP_PARTITION 0
 #  endif
 
+// Use the nvs header internally for persisting the progress of ota updates, as long as the header exists,
+// to allow an interrupted update to continue from the last saved chunk after a disconnect or reboot, instead of downloading the complete firmware again.
+#  ifdef __has_include
+#    if  __has_include(<nvs.h>)
+#      ifndef THINGSBOARD_USE_ESP_NVS
+#        define THINGSBOARD_USE_ESP_NVS 1
+#      endif
+#    else
+#      ifndef THINGSBOARD_USE_ESP_NVS
+#        define THINGSBOARD_USE_ESP_NVS 0
+#      endif
+#    endif
+#  else
+#    define THINGSBOARD_USE_ESP_NVS 0
+#  endif
+
 // Use the pgmspace header internally for enalbing the usage of the PROGMEm header for constant variables, as long as the header exists,
 // to allow variables to be placed into flash memory instead of sram, meaning the sram can be allocated for other things.
 #  ifdef __has_include
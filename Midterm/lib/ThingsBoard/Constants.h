@@ -31,6 +31,9 @@ class ThingsBoardDefaultLogger;
 #ifndef strncmp_P
 #define strncmp_P   strncmp
 #endif // strncmp_P
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr)   (*reinterpret_cast<const uint8_t*>(addr))
+#endif // pgm_read_byte
 #endif // THINGSBOARD_ENABLE_PROGMEM
 
 
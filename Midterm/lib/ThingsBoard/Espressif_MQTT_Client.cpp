@@ -13,6 +13,7 @@ Espressif_MQTT_Client *Espressif_MQTT_Client::m_instance = nullptr;
 
 Espressif_MQTT_Client::Espressif_MQTT_Client() :
     m_received_data_callback(nullptr),
+    m_delivery_callback(nullptr),
     m_connected(false),
     m_enqueue_messages(false),
     m_mqtt_configuration(),
@@ -108,6 +109,10 @@ void Espressif_MQTT_Client::set_callback(function callback) {
     m_received_data_callback = callback;
 }
 
+void Espressif_MQTT_Client::set_delivery_callback(delivery_function callback) {
+    m_delivery_callback = callback;
+}
+
 bool Espressif_MQTT_Client::set_buffer_size(const uint16_t& buffer_size) {
     // ESP_IDF_VERSION_MAJOR Version 5 is a major breaking changes were the complete esp_mqtt_client_config_t structure changed completely
 #if ESP_IDF_VERSION_MAJOR < 5
@@ -226,6 +231,44 @@ bool Espressif_MQTT_Client::publish(const char *topic, const uint8_t *payload, c
     return message_id > MQTT_FAILURE_MESSAGE_ID;
 }
 
+bool Espressif_MQTT_Client::publish(const char *topic, const uint8_t *payload, const size_t& length, const uint8_t& qos, uint16_t *message_id) {
+    if (qos == 0U) {
+        return publish(topic, payload, length);
+    }
+    // Messages with a quality of service above 0 are kept in the outbox of the client until the broker acknowledges them,
+    // the MQTT_EVENT_PUBLISHED event then reports the returned message id
+    const int id = m_enqueue_messages
+      ? esp_mqtt_client_enqueue(m_mqtt_client, topic, reinterpret_cast<const char*>(payload), length, qos, 0U, true)
+      : esp_mqtt_client_publish(m_mqtt_client, topic, reinterpret_cast<const char*>(payload), length, qos, 0U);
+    if (id <= MQTT_FAILURE_MESSAGE_ID) {
+        return false;
+    }
+    if (message_id != nullptr) {
+        *message_id = static_cast<uint16_t>(id);
+    }
+    return true;
+}
+
+bool Espressif_MQTT_Client::publish_segments(const char *topic, const uint8_t *const *segments, const size_t *lengths, const size_t& count) {
+    // esp-mqtt only accepts one contiguous payload, but it is not limited by the buffer size, because bigger messages are written in multiple parts
+    size_t length = 0U;
+    for (size_t i = 0U; i < count; i++) {
+        length += lengths[i];
+    }
+    uint8_t *payload = new uint8_t[length];
+    size_t position = 0U;
+    for (size_t i = 0U; i < count; i++) {
+        memcpy(payload + position, segments[i], lengths[i]);
+        position += lengths[i];
+    }
+    const bool result = publish(topic, payload, length);
+    // Ensure to actually delete the memory placed onto the heap, to make sure we do not create a memory leak
+    // and set the pointer to null so we do not have a dangling reference.
+    delete[] payload;
+    payload = nullptr;
+    return result;
+}
+
 bool Espressif_MQTT_Client::subscribe(const char *topic) {
     const int message_id = esp_mqtt_client_subscribe(m_mqtt_client, topic, 0U);
     return message_id > MQTT_FAILURE_MESSAGE_ID;
@@ -240,6 +283,16 @@ bool Espressif_MQTT_Client::connected() {
     return m_connected;
 }
 
+uint8_t *Espressif_MQTT_Client::begin_buffered_publish(const char *topic, size_t& capacity) {
+    // The esp-mqtt client does not give access to its output buffer, publish() copies the payload instead
+    capacity = 0U;
+    return nullptr;
+}
+
+bool Espressif_MQTT_Client::end_buffered_publish(const size_t& length) {
+    return false;
+}
+
 bool Espressif_MQTT_Client::update_configuration() {
     // Check if the client has been initalized, because if it did not the value should still be nullptr
     // and updating the config makes no sense because the changed settings will be applied anyway when the client is first intialized
@@ -268,8 +321,18 @@ void Espressif_MQTT_Client::mqtt_event_handler(void *handler_args, esp_event_bas
             // Nothing to do
             break;
         case esp_mqtt_event_id_t::MQTT_EVENT_PUBLISHED:
-            // Nothing to do
+            if (m_delivery_callback != nullptr) {
+                m_delivery_callback(static_cast<uint16_t>(event->msg_id), true);
+            }
+            break;
+#if ESP_IDF_VERSION_MAJOR >= 5
+        case esp_mqtt_event_id_t::MQTT_EVENT_DELETED:
+            // The message expired in the outbox before the broker acknowledged it
+            if (m_delivery_callback != nullptr) {
+                m_delivery_callback(static_cast<uint16_t>(event->msg_id), false);
+            }
             break;
+#endif // ESP_IDF_VERSION_MAJOR >= 5
         case esp_mqtt_event_id_t::MQTT_EVENT_DATA:
             // Check wheter the given message has not bee received completly, but instead would be received in multiple chunks,
             // if it were we discard the message because receiving a message over multiple chunks is currently not supported
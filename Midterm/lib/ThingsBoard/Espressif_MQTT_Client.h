@@ -89,6 +89,8 @@ class Espressif_MQTT_Client : public IMQTT_Client {
 
     void set_callback(function callback) override;
 
+    void set_delivery_callback(delivery_function callback) override;
+
     bool set_buffer_size(const uint16_t& buffer_size) override;
 
     uint16_t get_buffer_size() override;
@@ -103,14 +105,23 @@ class Espressif_MQTT_Client : public IMQTT_Client {
 
     bool publish(const char *topic, const uint8_t *payload, const size_t& length) override;
 
+    bool publish(const char *topic, const uint8_t *payload, const size_t& length, const uint8_t& qos, uint16_t *message_id) override;
+
+    bool publish_segments(const char *topic, const uint8_t *const *segments, const size_t *lengths, const size_t& count) override;
+
     bool subscribe(const char *topic) override;
 
     bool unsubscribe(const char *topic) override;
 
     bool connected() override;
 
+    uint8_t *begin_buffered_publish(const char *topic, size_t& capacity) override;
+
+    bool end_buffered_publish(const size_t& length) override;
+
 private:
     function m_received_data_callback;             // Callback that will be called as soon as the mqtt client receives any data
+    delivery_function m_delivery_callback;         // Callback that will be called once a message with a quality of service above 0 was acknowledged or dropped
     bool m_connected;                              // Whether the client has received the connected or disconnected event
     bool m_enqueue_messages;                       // Whether we enqueue messages making nearly all ThingsBoard calls non blocking or wheter we publish instead
     esp_mqtt_client_config_t m_mqtt_configuration; // Configuration of the underlying mqtt client, saved as a private variable to allow changes after inital configuration with the same options for all non changed settings
@@ -7,11 +7,19 @@
 
 // Library include.
 #include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_flash_encrypt.h>
+
+
+// Size of a flash sector, the smallest area that can be erased
+constexpr size_t FLASH_SECTOR_SIZE = 4096U;
 
 
 Espressif_Updater::Espressif_Updater() :
     m_ota_handle(0U),
-    m_update_partition(nullptr)
+    m_update_partition(nullptr),
+    m_write_offset(0U),
+    m_resumed(false)
 {
     // Nothing to do
 }
@@ -42,21 +50,77 @@ bool Espressif_Updater::begin(const size_t& firmware_size) {
 
     m_ota_handle = ota_handle;
     m_update_partition = update_partition;
+    m_resumed = false;
     return true;
 }
 
 size_t Espressif_Updater::write(uint8_t* payload, const size_t& total_bytes) {
+    if (m_resumed) {
+        const esp_err_t error = esp_partition_write(static_cast<const esp_partition_t*>(m_update_partition), m_write_offset, payload, total_bytes);
+        if (error != ESP_OK) {
+            return 0U;
+        }
+        m_write_offset += total_bytes;
+        return total_bytes;
+    }
     const esp_err_t error = esp_ota_write(m_ota_handle, payload, total_bytes);
     const size_t written_bytes = (error == ESP_OK) ? total_bytes : 0U;
     return written_bytes;
 }
 
+bool Espressif_Updater::resume(const size_t& firmware_size, const size_t& written_bytes) {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_partition_t *configured = esp_ota_get_boot_partition();
+    if (configured != running) {
+        return false;
+    }
+
+    const esp_partition_t *update_partition = esp_ota_get_next_update_partition(nullptr);
+    if (update_partition == nullptr || firmware_size > update_partition->size || written_bytes > firmware_size) {
+        return false;
+    }
+
+    // Encrypted partitions can only be written through the ota handle and the erase below must not touch already written sectors
+    if (esp_flash_encryption_enabled() || (written_bytes % FLASH_SECTOR_SIZE) != 0U) {
+        return false;
+    }
+
+    // An update begun on this connection may still hold its ota handle, release it before writing around it
+    reset();
+
+    // Chunks written after the progress was saved might have been interrupted halfway, erase everything after the saved offset so it can be written again
+    const size_t image_end = ((firmware_size + FLASH_SECTOR_SIZE - 1U) / FLASH_SECTOR_SIZE) * FLASH_SECTOR_SIZE;
+    if (image_end > written_bytes && esp_partition_erase_range(update_partition, written_bytes, image_end - written_bytes) != ESP_OK) {
+        return false;
+    }
+
+    m_update_partition = update_partition;
+    m_write_offset = written_bytes;
+    m_resumed = true;
+    return true;
+}
+
 void Espressif_Updater::reset() {
+    if (m_resumed) {
+        m_resumed = false;
+        return;
+    }
+    if (m_ota_handle == 0U) {
+        return;
+    }
     (void)esp_ota_abort(m_ota_handle);
+    m_ota_handle = 0U;
 }
 
 bool Espressif_Updater::end() {
+    if (m_resumed) {
+        // Setting the boot partition verifies the complete image first, which replaces the check esp_ota_end would do
+        m_resumed = false;
+        return esp_ota_set_boot_partition(static_cast<const esp_partition_t*>(m_update_partition)) == ESP_OK;
+    }
     esp_err_t error = esp_ota_end(m_ota_handle);
+    // The handle is freed by esp_ota_end even if validating the image failed
+    m_ota_handle = 0U;
     if (error != ESP_OK) {
         return false;
     }
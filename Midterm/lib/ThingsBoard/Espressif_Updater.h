@@ -13,7 +13,8 @@
 
 
 /// @brief IUpdater implementation that uses the Over the Air Update API from Espressif (https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/ota.html)
-/// under the hood to write the given binary firmware data into flash memory so we can restart with newly received firmware
+/// under the hood to write the given binary firmware data into flash memory so we can restart with newly received firmware.
+/// A resumed update writes directly into the update partition after the already written bytes, because the ota handle of the interrupted update does not exist anymore
 class Espressif_Updater : public IUpdater {
   public:
     Espressif_Updater();
@@ -22,6 +23,8 @@ class Espressif_Updater : public IUpdater {
   
     size_t write(uint8_t* payload, const size_t& total_bytes) override;
 
+    bool resume(const size_t& firmware_size, const size_t& written_bytes) override;
+
     void reset() override;
   
     bool end() override;
@@ -29,6 +32,8 @@ class Espressif_Updater : public IUpdater {
     private:
       uint32_t m_ota_handle;
       const void *m_update_partition;
+      size_t m_write_offset; // Offset in the update partition the next bytes are written to, only used if the update was resumed
+      bool m_resumed;        // Whether the update was resumed and is written without the ota handle
 };
 
 #endif // THINGSBOARD_USE_ESP_PARTITION
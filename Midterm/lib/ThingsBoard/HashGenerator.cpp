@@ -6,6 +6,12 @@
 // Library includes.
 #include <sstream>
 #include <iomanip>
+#include <string.h>
+#if THINGSBOARD_USE_MBED_TLS
+#include <mbedtls/md5.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/sha512.h>
+#endif // THINGSBOARD_USE_MBED_TLS
 
 HashGenerator::HashGenerator() :
     m_ctx()
@@ -39,6 +45,24 @@ bool HashGenerator::update(const uint8_t* data, const size_t& len) {
     return mbedtls_md_update(&m_ctx, data, len) == 0;
 }
 
+size_t HashGenerator::save(uint8_t *buffer, const size_t& size) const {
+    const size_t context_size = get_context_size();
+    if (context_size == 0U || context_size > size) {
+        return 0U;
+    }
+    memcpy(buffer, get_context(), context_size);
+    return context_size;
+}
+
+bool HashGenerator::restore(const uint8_t *buffer, const size_t& size) {
+    const size_t context_size = get_context_size();
+    if (context_size == 0U || context_size != size) {
+        return false;
+    }
+    memcpy(get_context(), buffer, context_size);
+    return true;
+}
+
 std::string HashGenerator::get_hash_string() {
     // Calculate the current hash value
     uint8_t hash[MBEDTLS_MD_MAX_SIZE];
@@ -60,4 +84,38 @@ void HashGenerator::finish(unsigned char *hash) {
     mbedtls_md_finish(&m_ctx, hash);
 }
 
+size_t HashGenerator::get_context_size() const {
+    // MBEDTLS Version 3 is a major breaking changes were accessing the internal structures requires the MBEDTLS_PRIVATE macro
+#if MBEDTLS_VERSION_MAJOR < 3
+    const mbedtls_md_info_t *md_info = m_ctx.md_info;
+#else
+    const mbedtls_md_info_t *md_info = m_ctx.MBEDTLS_PRIVATE(md_info);
+#endif
+    if (md_info == nullptr) {
+        return 0U;
+    }
+
+    switch (mbedtls_md_get_type(md_info)) {
+        case mbedtls_md_type_t::MBEDTLS_MD_MD5:
+            return sizeof(mbedtls_md5_context);
+#if !CONFIG_IDF_TARGET_ESP32
+        case mbedtls_md_type_t::MBEDTLS_MD_SHA256:
+            return sizeof(mbedtls_sha256_context);
+        case mbedtls_md_type_t::MBEDTLS_MD_SHA384:
+        case mbedtls_md_type_t::MBEDTLS_MD_SHA512:
+            return sizeof(mbedtls_sha512_context);
+#endif // !CONFIG_IDF_TARGET_ESP32
+        default:
+            return 0U;
+    }
+}
+
+void* HashGenerator::get_context() const {
+#if MBEDTLS_VERSION_MAJOR < 3
+    return m_ctx.md_ctx;
+#else
+    return m_ctx.MBEDTLS_PRIVATE(md_ctx);
+#endif
+}
+
 #endif // THINGSBOARD_ENABLE_OTA
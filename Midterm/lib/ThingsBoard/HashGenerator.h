@@ -41,6 +41,19 @@ class HashGenerator {
     /// @return Whether updating the hash for the given bytes was successful or not
     bool update(const uint8_t* data, const size_t& len);
 
+    /// @brief Copies the intermediate state of the started hash into the given buffer, so the hash can be continued later with restore(),
+    /// even after a reboot. Not supported on the original ESP32, because its SHA accelerator keeps the intermediate state inside of the peripheral
+    /// @param buffer Output byte array that the state will be copied into
+    /// @param size Size of the output byte array
+    /// @return Amount of bytes copied into the buffer, 0 if the state could not be copied
+    size_t save(uint8_t *buffer, const size_t& size) const;
+
+    /// @brief Replaces the state of the hash with one previously copied with save(), start() has to be called with the same type first
+    /// @param buffer Byte array containing the previously saved state
+    /// @param size Amount of bytes in the previously saved state
+    /// @return Whether the state was restored and the hash can be continued with update() or not
+    bool restore(const uint8_t *buffer, const size_t& size);
+
     /// @brief Returns the final hash value as a string
     /// @return String containing the final hash value for the passed bytes
     std::string get_hash_string();
@@ -48,6 +61,14 @@ class HashGenerator {
   private:
     mbedtls_md_context_t m_ctx; // Context used to access the already written bytes and update them latter
 
+    /// @brief Returns the size of the algorithm specific context, which contains the complete intermediate state of the hash
+    /// @return Size of the context or 0 if the state of the current algorithm can not be copied
+    size_t get_context_size() const;
+
+    /// @brief Returns the algorithm specific context of the started hash
+    /// @return Pointer to the context
+    void* get_context() const;
+
     /// @brief Calculates the final hash value
     /// @param hash Output byte array that the hash value will be copied into
     void finish(unsigned char *hash);
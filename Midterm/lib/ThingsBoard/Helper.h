@@ -28,6 +28,15 @@ class Helper {
     /// @return Amount of occurences of the given symbol
     static size_t getOccurences(const char *str, char symbol);
 
+    /// @brief Calculates the 32 bit FNV-1a hash of the given string, evaluated at compile time if the string is a literal.
+    /// See http://www.isthe.com/chongo/tech/comp/fnv/ for more information on the algorithm
+    /// @param str String that we want to hash
+    /// @param hash Hash of the characters before the given string, keep the default to hash a complete string
+    /// @return Hash of the given string
+    static constexpr uint32_t hashString(const char *str, const uint32_t hash = 2166136261U) {
+      return (*str == '\0') ? hash : hashString(str + 1, (hash ^ static_cast<uint8_t>(*str)) * 16777619U);
+    }
+
     /// @brief Calculates the total size of the string the serializeJson method would produce including the null end terminator.
     /// See https://arduinojson.org/v6/api/json/measurejson/ for more information on the underlying method used
     /// @tparam TSource Source class that should be used to serialize the json that is sent to the server
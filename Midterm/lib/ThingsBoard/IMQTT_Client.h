@@ -13,6 +13,7 @@
 #endif // THINGSBOARD_ENABLE_STREAM_UTILS
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 
 /// @brief MQTT Client interface that contains the method that a class that can be used to send and receive data over an MQTT connection should implement.
@@ -41,11 +42,23 @@ class IMQTT_Client {
     using function = void (*)(char *topic, uint8_t *payload, unsigned int length);
 #endif // THINGSBOARD_ENABLE_STL
 
+    /// @brief Delivery callback signature
+#if THINGSBOARD_ENABLE_STL
+    using delivery_function = std::function<void(uint16_t message_id, bool delivered)>;
+#else
+    using delivery_function = void (*)(uint16_t message_id, bool delivered);
+#endif // THINGSBOARD_ENABLE_STL
+
     /// @brief Sets the callback that is called, if any message is received by the MQTT broker, including the topic string that the message was received over,
     /// as well as the payload data and the size of that payload data
     /// @param callback Method that should be called on received MQTT response
     virtual void set_callback(function callback) = 0;
 
+    /// @brief Sets the callback that is called once a message published with a quality of service above 0 has been acknowledged by the MQTT broker (delivered = true),
+    /// or has been given up on by the client (delivered = false), including the message id that publish() returned for that message
+    /// @param callback Method that should be called on delivery or loss of a published message
+    virtual void set_delivery_callback(delivery_function callback) = 0;
+
     /// @brief Changes the size of the buffer for sent and received MQTT messages,
     /// using a bigger value than uint16_t for passing the buffer size does not make any sense because the maximum message size received
     /// or sent by MQTT can never be bigger than 64K, because it relies on TCP and the TCP size limit also uses a uint16_t internally for the size parameter
@@ -93,6 +106,27 @@ class IMQTT_Client {
     /// @return Whether publishing the payload on the given topic was successful or not
     virtual bool publish(const char *topic, const uint8_t *payload, const size_t& length) = 0;
 
+    /// @brief Sends the given payload with the given quality of service over the previously established connection with connect.
+    /// With a quality of service of 1 the client keeps the message until the broker acknowledges it and resends it if needed,
+    /// the outcome is reported to the callback configured with set_delivery_callback()
+    /// @param topic Topic that the message is sent over, where different MQTT topics expect a different kind of payload
+    /// @param payload Payload containg the json data that should be sent
+    /// @param length Length of the payload in bytes
+    /// @param qos Quality of service the message is sent with, 0 or 1
+    /// @param message_id Set to the id the delivery callback reports the message with, may be nullptr
+    /// @return Whether publishing the payload on the given topic was successful or not,
+    /// should return false if the client can not keep any more unacknowledged messages at the moment
+    virtual bool publish(const char *topic, const uint8_t *payload, const size_t& length, const uint8_t& qos, uint16_t *message_id) = 0;
+
+    /// @brief Sends a payload consisting of multiple segments, as if they were one contiguous payload, over the previously established connection with connect.
+    /// The segments should be sent without first copying them into one buffer, so the payload may be bigger than the internal buffer size of the client
+    /// @param topic Topic that the message is sent over, where different MQTT topics expect a different kind of payload
+    /// @param segments Pointers to the segments of the payload, in the order they should be sent
+    /// @param lengths Length of each segment in bytes
+    /// @param count Amount of segments
+    /// @return Whether publishing the payload on the given topic was successful or not
+    virtual bool publish_segments(const char *topic, const uint8_t *const *segments, const size_t *lengths, const size_t& count) = 0;
+
     /// @brief Subscribes to MQTT message on the given topic, which will cause an internal callback to be called for each message received on that topic from the server,
     /// it should then, call the previously configured callback with set_callback() with the received data
     /// @param topic Topic we want to receive a notification about if messages are sent by the server
@@ -111,6 +145,20 @@ class IMQTT_Client {
     /// @return Whether the client is currently connected or not
     virtual bool connected() = 0;
 
+    /// @brief Starts to publish a message whose payload is written directly into the internal buffer of the client, after the space reserved for the MQTT header and the topic.
+    /// Removes the copy of the payload into the client, to use this feature first call begin_buffered_publish(), then write at most capacity bytes of payload into the returned memory,
+    /// for example by serializing json with an MQTT_Buffer_Writer, and then call end_buffered_publish(). The client may not be used for anything else in between
+    /// @param topic Topic that the message is sent over, where different MQTT topics expect a different kind of payload
+    /// @param capacity Set to the amount of payload bytes that fit into the returned memory
+    /// @return Memory the payload should be written into, nullptr if the client does not support writing into its buffer,
+    /// is not connected or the topic does not leave room for any payload, in that case publish() has to be used instead
+    virtual uint8_t *begin_buffered_publish(const char *topic, size_t& capacity) = 0;
+
+    /// @brief Sends the message started with begin_buffered_publish(), after filling in the MQTT header
+    /// @param length Amount of payload bytes written into the memory returned by begin_buffered_publish()
+    /// @return Whether the complete packet was sent successfully or not
+    virtual bool end_buffered_publish(const size_t& length) = 0;
+
 #if THINGSBOARD_ENABLE_STREAM_UTILS
 
     /// @brief Start to publish a message over a given topic, without being restricted to the internal buffer size.
@@ -147,4 +195,65 @@ class IMQTT_Client {
 #endif // THINGSBOARD_ENABLE_STREAM_UTILS
 };
 
+/// @brief Custom ArduinoJson writer (https://arduinojson.org/v6/api/json/serializejson/) that writes into the memory returned by IMQTT_Client::begin_buffered_publish().
+/// Writing stops once the memory is full, which is reported by overflowed(), instead of writing past the end
+class MQTT_Buffer_Writer {
+  public:
+    /// @brief Constructs a writer for the given memory
+    /// @param buffer Memory the payload is written into
+    /// @param capacity Size of the memory in bytes
+    inline MQTT_Buffer_Writer(uint8_t *buffer, const size_t& capacity)
+      : m_buffer(buffer)
+      , m_capacity(capacity)
+      , m_length(0U)
+      , m_overflowed(false)
+    {
+      // Nothing to do
+    }
+
+    /// @brief Writes a single byte
+    /// @param payload_byte Byte that should be written
+    /// @return The amount of bytes successfully written
+    inline size_t write(uint8_t payload_byte) {
+      if (m_length >= m_capacity) {
+        m_overflowed = true;
+        return 0U;
+      }
+      m_buffer[m_length++] = payload_byte;
+      return 1U;
+    }
+
+    /// @brief Writes multiple bytes
+    /// @param buffer Bytes that should be written
+    /// @param size Amount of bytes that should be written
+    /// @return The amount of bytes successfully written
+    inline size_t write(const uint8_t *buffer, size_t size) {
+      if (size > m_capacity - m_length) {
+        size = m_capacity - m_length;
+        m_overflowed = true;
+      }
+      memcpy(m_buffer + m_length, buffer, size);
+      m_length += size;
+      return size;
+    }
+
+    /// @brief Returns the amount of bytes written so far
+    /// @return Amount of bytes written
+    inline const size_t& length() const {
+      return m_length;
+    }
+
+    /// @brief Returns whether more bytes were written than fit into the memory
+    /// @return Whether the written payload is incomplete
+    inline const bool& overflowed() const {
+      return m_overflowed;
+    }
+
+  private:
+    uint8_t *m_buffer; // Memory the payload is written into
+    size_t m_capacity; // Size of the memory
+    size_t m_length; // Amount of bytes written
+    bool m_overflowed; // Whether bytes had to be discarded
+};
+
 #endif // IMQTT_Client_h
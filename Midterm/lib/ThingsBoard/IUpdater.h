@@ -24,6 +24,18 @@ class IUpdater {
     /// @param total_bytes Amount of bytes in the current firmware packet data
     /// @return Total amount of bytes that were successfully written
     virtual size_t write(uint8_t* payload, const size_t& total_bytes) = 0;
+
+    /// @brief Continues writing an update that was interrupted by a disconnect or reboot, instead of initalizing it again with begin.
+    /// The first written_bytes of the firmware have already been written into the same flash location and are kept, following writes continue after them.
+    /// Implementations that can not continue a previous update keep the default, which makes the update start again from the first chunk
+    /// @param firmware_size Total size of the data that should be written, has to be the same as the one the update was initally started with
+    /// @param written_bytes Amount of bytes that were already written and verified before the update was interrupted
+    /// @return Whether continuing the update was successful or not
+    virtual bool resume(const size_t& firmware_size, const size_t& written_bytes) {
+      (void)firmware_size;
+      (void)written_bytes;
+      return false;
+    }
   
     /// @brief Resets the writing of the given data so it can be restarted with begin
     virtual void reset() = 0;
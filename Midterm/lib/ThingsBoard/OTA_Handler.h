@@ -12,6 +12,13 @@
 #include "Helper.h"
 #include "OTA_Update_Callback.h"
 #include "OTA_Failure_Response.h"
+#include "OTA_Resume_Storage.h"
+
+// Library includes.
+#include <new>
+#if THINGSBOARD_USE_ESP_TIMER
+#include <esp_timer.h>
+#endif // THINGSBOARD_USE_ESP_TIMER
 
 
 /// ---------------------------------
@@ -37,7 +44,8 @@ constexpr char FW_STATE_FAILED[] = "FAILED";
 // Log messages.
 #if THINGSBOARD_ENABLE_PROGMEM
 constexpr char UNABLE_TO_REQUEST_CHUNCKS[] PROGMEM = "Unable to request firmware chunk";
-constexpr char RECEIVED_UNEXPECTED_CHUNK[] PROGMEM = "Received chunk (%u), not the same as requested chunk (%u)";
+constexpr char RECEIVED_UNEXPECTED_CHUNK[] PROGMEM = "Received chunk (%u), outside of the requested window starting at chunk (%u)";
+constexpr char UNABLE_TO_ALLOCATE_REORDER_BUFFER[] PROGMEM = "Unable to allocate (%u) bytes to reorder firmware chunks, requesting one chunk at a time instead";
 constexpr char ERROR_UPDATE_BEGIN[] PROGMEM = "Failed to initalize flash updater";
 constexpr char ERROR_UPDATE_WRITE[] PROGMEM = "Only wrote (%u) bytes of binary data to flash memory instead of expected (%u)";
 constexpr char UPDATING_HASH_FAILED[] PROGMEM = "Updating hash failed";
@@ -49,9 +57,11 @@ constexpr char HASH_EXPECTED[] PROGMEM = "(%s) expected checksum: (%s)";
 constexpr char CHKS_VER_SUCCESS[] PROGMEM = "Checksum is the same as expected";
 constexpr char FW_UPDATE_ABORTED[] PROGMEM = "Firmware update aborted";
 constexpr char FW_UPDATE_SUCCESS[] PROGMEM = "Update success";
+constexpr char RESUMING_FW_UPDATE[] PROGMEM = "Resuming firmware update at chunk (%u) of (%u)";
 #else
 constexpr char UNABLE_TO_REQUEST_CHUNCKS[] = "Unable to request firmware chunk";
-constexpr char RECEIVED_UNEXPECTED_CHUNK[] = "Received chunk (%u), not the same as requested chunk (%u)";
+constexpr char RECEIVED_UNEXPECTED_CHUNK[] = "Received chunk (%u), outside of the requested window starting at chunk (%u)";
+constexpr char UNABLE_TO_ALLOCATE_REORDER_BUFFER[] = "Unable to allocate (%u) bytes to reorder firmware chunks, requesting one chunk at a time instead";
 constexpr char ERROR_UPDATE_BEGIN[] = "Failed to initalize flash updater";
 constexpr char ERROR_UPDATE_WRITE[] = "Only wrote (%u) bytes of binary data to flash memory instead of expected (%u)";
 constexpr char UPDATING_HASH_FAILED[] = "Updating hash failed";
@@ -63,11 +73,22 @@ constexpr char HASH_EXPECTED[] = "(%s) expected checksum: (%s)";
 constexpr char CHKS_VER_SUCCESS[] = "Checksum is the same as expected";
 constexpr char FW_UPDATE_ABORTED[] = "Firmware update aborted";
 constexpr char FW_UPDATE_SUCCESS[] = "Update success";
+constexpr char RESUMING_FW_UPDATE[] = "Resuming firmware update at chunk (%u) of (%u)";
 #endif // THINGSBOARD_ENABLE_PROGMEM
 
+// Upper limit for the amount of chunk requests that are outstanding at once, larger window sizes of the OTA_Update_Callback are clamped to it
+constexpr uint8_t MAX_CHUNK_WINDOW = 16U;
+// The progress of the update is persisted every time at least this many bytes have been written since it was last saved
+constexpr size_t RESUME_SAVE_INTERVAL = 32U * 1024U;
+// Progress is only saved at offsets aligned to the flash sector size, so a resumed update can erase everything after the saved offset
+// without touching sectors that contain already written data. Chunk sizes that are a multiple of it allow to save after every chunk
+constexpr size_t RESUME_ALIGNMENT = 4096U;
+
 
 /// @brief Handles the complete processing of received binary firmware data, including flashing it onto the device,
-/// creating a hash of the received data and in the end ensuring that the complete OTA firmware was flashes successfully and that the hash is the one we initally received
+/// creating a hash of the received data and in the end ensuring that the complete OTA firmware was flashes successfully and that the hash is the one we initally received.
+/// Multiple chunks are requested at once to hide the round trip time of the connection, but they are always written into flash memory and hashed in order,
+/// chunks that arrive before the one that has to be written next are held back in a reorder buffer until the missing chunk arrived
 /// @tparam Logger Logging class that should be used to print messages generated by internal processes
 template<typename Logger>
 class OTA_Handler {
@@ -81,27 +102,44 @@ class OTA_Handler {
         , m_publish_callback(publish_callback)
         , m_send_fw_state_callback(send_fw_state_callback)
         , m_finish_callback(finish_callback)
+        , m_fw_title()
+        , m_fw_version()
         , m_fw_size(0U)
         , m_fw_algorithm()
         , m_fw_checksum()
         , m_fw_checksum_algorithm()
         , m_hash()
         , m_total_chunks(0U)
-        , m_requested_chunks(0U)
+        , m_written_chunks(0U)
+        , m_next_request(0U)
+        , m_window(1U)
+        , m_chunks()
+        , m_reorder_buffer(nullptr)
+        , m_saved_bytes(0U)
         , m_retries(0U)
         , m_watchdog(std::bind(&OTA_Handler::Handle_Request_Timeout, this))
     {
       // Nothing to do
     }
 
-    /// @brief Starts the firmware update with requesting the first firmware packet and initalizes the underlying needed components
+    /// @brief Destructor
+    inline ~OTA_Handler() {
+      Release_Reorder_Buffer();
+    }
+
+    /// @brief Starts the firmware update and initalizes the underlying needed components. If the progress of an interrupted update of the same firmware was saved,
+    /// the update continues after the last saved chunk, otherwise it starts by requesting the first firmware packets
     /// @param fw_callback Callback method that contains configuration information, about the over the air update
+    /// @param fw_title Title of the firmware that will be downloaded, used to recognize saved progress of the same firmware
+    /// @param fw_version Version of the firmware that will be downloaded, used to recognize saved progress of the same firmware
     /// @param fw_size Complete size of the firmware binary that will be downloaded and flashed onto this device
     /// @param fw_algorithm String of the algorithm type used to hash the firmware binary
     /// @param fw_checksum Checksum of the complete firmware binary, should be the same as the actually written data in the end
     /// @param fw_checksum_algorithm Algorithm type used to hash the firmware binary
-    inline void Start_Firmware_Update(const OTA_Update_Callback *fw_callback, const size_t& fw_size, const std::string& fw_algorithm, const std::string& fw_checksum, const mbedtls_md_type_t& fw_checksum_algorithm) {
+    inline void Start_Firmware_Update(const OTA_Update_Callback *fw_callback, const char *fw_title, const char *fw_version, const size_t& fw_size, const std::string& fw_algorithm, const std::string& fw_checksum, const mbedtls_md_type_t& fw_checksum_algorithm) {
         m_fw_callback = fw_callback;
+        m_fw_title = fw_title;
+        m_fw_version = fw_version;
         m_fw_size = fw_size;
         m_total_chunks = (m_fw_size / m_fw_callback->Get_Chunk_Size()) + 1U;
         m_fw_algorithm = fw_algorithm;
@@ -114,7 +152,10 @@ class OTA_Handler {
           (void)m_send_fw_state_callback(FW_STATE_FAILED, OTA_CB_IS_NULL);
             return Handle_Failure(OTA_Failure_Response::RETRY_NOTHING);
         }
-        Request_First_Firmware_Packet();
+        Allocate_Reorder_Buffer();
+        if (!Resume_Firmware_Update()) {
+          Request_First_Firmware_Packet();
+        }
     }
 
     /// @brief Stops the firmware update completly and informs that user that the update has failed because it has been aborted, ongoing communication is discarded.
@@ -129,23 +170,135 @@ class OTA_Handler {
         m_fw_callback = nullptr;
     }
 
-    /// @brief Uses the given firmware packet data and process it. Starting with writing the given amount of bytes of the packet data into flash memory and
-    /// into a hash function that will be used to compare the expected complete binary file and the actually received binary file
+    /// @brief Uses the given firmware packet data and process it. If it is the chunk that has to be written next, the given amount of bytes of the packet data
+    /// is written into flash memory and into a hash function that will be used to compare the expected complete binary file and the actually received binary file,
+    /// followed by any directly following chunks that arrived earlier. Otherwise the packet data is copied into the reorder buffer until the missing chunks arrived
     /// @param current_chunk Index of the chunk we recieved the binary data for
     /// @param payload Firmware packet data of the current chunk
     /// @param total_bytes Amount of bytes in the current firmware packet data
     inline void Process_Firmware_Packet(const size_t& current_chunk, uint8_t *payload, const size_t& total_bytes) {
         (void)m_send_fw_state_callback(FW_STATE_DOWNLOADING, nullptr);
 
-        if (current_chunk != m_requested_chunks) {
-          char message[Helper::detectSize(RECEIVED_UNEXPECTED_CHUNK, current_chunk, m_requested_chunks)];
-          snprintf_P(message, sizeof(message), RECEIVED_UNEXPECTED_CHUNK, current_chunk, m_requested_chunks);
+        // Chunks that were already written or that were never requested, are duplicates of a re-request or not meant for this update
+        if (current_chunk < m_written_chunks || current_chunk >= m_next_request) {
+          char message[Helper::detectSize(RECEIVED_UNEXPECTED_CHUNK, current_chunk, m_written_chunks)];
+          snprintf_P(message, sizeof(message), RECEIVED_UNEXPECTED_CHUNK, current_chunk, m_written_chunks);
           Logger::log(message);
           return;
         }
 
+        Chunk_Slot& slot = m_chunks[current_chunk % m_window];
+        if (current_chunk != m_written_chunks) {
+          // Chunk arrived before the one that has to be written next, hold it back. Keeping the first copy if it is received twice
+          if (!slot.received && total_bytes <= m_fw_callback->Get_Chunk_Size()) {
+            memcpy(Get_Reorder_Slot(current_chunk), payload, total_bytes);
+            slot.length = total_bytes;
+            slot.received = true;
+          }
+          return;
+        }
+
+        // Writing to flash can take longer than the timeout, so the watchdog is not allowed to re-request chunks in the meantime
         m_watchdog.detach();
 
+        if (!Write_Firmware_Chunk(current_chunk, payload, total_bytes)) {
+          return;
+        }
+
+        // Write any chunks that arrived early and directly follow the one we just wrote
+        while (m_written_chunks < m_next_request && m_chunks[m_written_chunks % m_window].received) {
+          const size_t chunk = m_written_chunks;
+          if (!Write_Firmware_Chunk(chunk, Get_Reorder_Slot(chunk), m_chunks[chunk % m_window].length)) {
+            return;
+          }
+        }
+
+        // Reset retries as the current chunk has been downloaded and handled successfully
+        m_retries = m_fw_callback->Get_Chunk_Retries();
+        Request_Next_Firmware_Packet();
+    }
+
+  private:
+    /// @brief State of a single chunk inside of the request window, the slot of a chunk is its index modulo the window size,
+    /// because the requested but not yet written chunks are always a consecutive range that is at most as long as the window
+    struct Chunk_Slot {
+        uint64_t requested_at; // Time in microseconds the chunk was last requested at, used to re-request only the chunks that timed out
+        size_t length;         // Amount of bytes held back in the reorder buffer for this chunk
+        bool received;         // Whether the chunk arrived early and is waiting in the reorder buffer
+    };
+
+    const OTA_Update_Callback *m_fw_callback;                                 // Callback method that contains configuration information, about the over the air update
+    std::function<bool(const size_t&)> m_publish_callback;                    // Callback that is used to request the firmware chunk of the firmware binary with the given chunk number
+    std::function<bool(const char *, const char *)> m_send_fw_state_callback; // Callback that is used to send information about the current state of the over the air update
+    std::function<bool(void)> m_finish_callback;                              // Callback that is called once the update has been finished and the user should be informed of the failure or success of the over the air update
+    std::string m_fw_title;                                                   // Title of the firmware that is downloaded, saved with the progress of the update
+    std::string m_fw_version;                                                 // Version of the firmware that is downloaded, saved with the progress of the update
+    size_t m_fw_size;                                                         // Total size of the firmware binary we will receive. Allows for a binary size of up to theoretically 4 GB
+    std::string m_fw_algorithm;                                               // String of the algorithm type used to hash the firmware binary
+    std::string m_fw_checksum;                                                // Checksum of the complete firmware binary, should be the same as the actually written data in the end
+    mbedtls_md_type_t m_fw_checksum_algorithm;                                // Algorithm type used to hash the firmware binary
+    IUpdater *m_fw_updater;                                                   // Interface implementation that writes received firmware binary data onto the given device
+    HashGenerator m_hash;                                                     // Class instance that allows to generate a hash from received firmware binary data
+    size_t m_total_chunks;                                                    // Total amount of chunks that need to be received to get the complete firmware binary
+    size_t m_written_chunks;                                                  // Amount of firmware binary chunks that have been received and written in order, is also the index of the chunk that has to be written next
+    size_t m_next_request;                                                    // Index of the next chunk that has not been requested yet
+    uint8_t m_window;                                                         // Amount of chunks that are requested at once, clamped to MAX_CHUNK_WINDOW and reduced to 1 if the reorder buffer could not be allocated
+    Chunk_Slot m_chunks[MAX_CHUNK_WINDOW];                                    // State of the requested but not yet written chunks
+    uint8_t *m_reorder_buffer;                                                // Holds back the chunks that arrived before the one that has to be written next, one chunk size per slot
+    size_t m_saved_bytes;                                                     // Amount of written bytes the progress of the update was last saved at
+    uint8_t m_retries;                                                        // Amount of request retries we attempt for each chunk, increasing makes the connection more stable
+    Callback_Watchdog m_watchdog;                                             // Class instances that allows to timeout if we do not receive a response for the oldest outstanding chunk in the given time
+
+    /// @brief Returns a monotonic time in microseconds, used to determine which of the requested chunks timed out
+    /// @return Microseconds since the device started
+    inline static uint64_t Get_Time_Us() {
+#if THINGSBOARD_USE_ESP_TIMER
+      return esp_timer_get_time();
+#else
+      return micros();
+#endif // THINGSBOARD_USE_ESP_TIMER
+    }
+
+    /// @brief Allocates the reorder buffer for the window size configured in the callback, falls back to a window of one chunk,
+    /// which does not need a reorder buffer, if the window size is 1 or the memory could not be allocated
+    inline void Allocate_Reorder_Buffer() {
+        Release_Reorder_Buffer();
+        const uint8_t& window = m_fw_callback->Get_Window_Size();
+        m_window = (window == 0U) ? 1U : ((window > MAX_CHUNK_WINDOW) ? MAX_CHUNK_WINDOW : window);
+        if (m_window == 1U) {
+          return;
+        }
+
+        const size_t buffer_size = static_cast<size_t>(m_window) * m_fw_callback->Get_Chunk_Size();
+        m_reorder_buffer = new (std::nothrow) uint8_t[buffer_size];
+        if (m_reorder_buffer == nullptr) {
+          char message[Helper::detectSize(UNABLE_TO_ALLOCATE_REORDER_BUFFER, buffer_size)];
+          snprintf_P(message, sizeof(message), UNABLE_TO_ALLOCATE_REORDER_BUFFER, buffer_size);
+          Logger::log(message);
+          m_window = 1U;
+        }
+    }
+
+    /// @brief Releases the reorder buffer, once the update has either finished or failed
+    inline void Release_Reorder_Buffer() {
+        delete[] m_reorder_buffer;
+        m_reorder_buffer = nullptr;
+    }
+
+    /// @brief Returns the part of the reorder buffer that holds back the given chunk
+    /// @param chunk Index of the chunk
+    /// @return Pointer to the chunk size bytes reserved for the given chunk
+    inline uint8_t* Get_Reorder_Slot(const size_t& chunk) const {
+        return m_reorder_buffer + ((chunk % m_window) * m_fw_callback->Get_Chunk_Size());
+    }
+
+    /// @brief Writes the given chunk into flash memory and into the hash and informs the user about the progress,
+    /// has to be called for every chunk in order
+    /// @param current_chunk Index of the chunk we write the binary data for, has to be the same as the amount of already written chunks
+    /// @param payload Firmware packet data of the current chunk
+    /// @param total_bytes Amount of bytes in the current firmware packet data
+    /// @return Whether the chunk was written and the update should continue, false if it failed and was restarted or it was cancelled by the progress callback
+    inline bool Write_Firmware_Chunk(const size_t& current_chunk, uint8_t *payload, const size_t& total_bytes) {
         char message[Helper::detectSize(FW_CHUNK, current_chunk, total_bytes)];
         snprintf_P(message, sizeof(message), FW_CHUNK, current_chunk, total_bytes);
         Logger::log(message);
@@ -155,7 +308,8 @@ class OTA_Handler {
             if (!m_fw_updater->begin(m_fw_size)) {
               Logger::log(ERROR_UPDATE_BEGIN);
               (void)m_send_fw_state_callback(FW_STATE_FAILED, ERROR_UPDATE_BEGIN);
-              return Handle_Failure(OTA_Failure_Response::RETRY_UPDATE);
+              Handle_Failure(OTA_Failure_Response::RETRY_UPDATE);
+              return false;
             }
         }
 
@@ -166,49 +320,111 @@ class OTA_Handler {
             snprintf_P(message, sizeof(message), ERROR_UPDATE_WRITE, written_bytes, total_bytes);
             Logger::log(message);
             (void)m_send_fw_state_callback(FW_STATE_FAILED, message);
-            return Handle_Failure(OTA_Failure_Response::RETRY_UPDATE);
+            Handle_Failure(OTA_Failure_Response::RETRY_UPDATE);
+            return false;
         }
 
         // Update value only if writing to flash was a success
         if (!m_hash.update(payload, total_bytes)) {
             Logger::log(UPDATING_HASH_FAILED);
             (void)m_send_fw_state_callback(FW_STATE_FAILED, UPDATING_HASH_FAILED);
-            return Handle_Failure(OTA_Failure_Response::RETRY_UPDATE);
+            Handle_Failure(OTA_Failure_Response::RETRY_UPDATE);
+            return false;
         }
 
-        m_requested_chunks = current_chunk + 1;
-        m_fw_callback->Call_Progress_Callback<Logger>(m_requested_chunks, m_total_chunks);
+        m_chunks[current_chunk % m_window].received = false;
+        m_written_chunks = current_chunk + 1U;
+
+        const size_t firmware_offset = m_written_chunks * m_fw_callback->Get_Chunk_Size();
+        if (m_written_chunks < m_total_chunks && (firmware_offset % RESUME_ALIGNMENT) == 0U && firmware_offset - m_saved_bytes >= RESUME_SAVE_INTERVAL) {
+            Save_Progress(firmware_offset);
+        }
+
+        m_fw_callback->Call_Progress_Callback<Logger>(m_written_chunks, m_total_chunks);
 
         // Ensure to check if the update was cancelled during the progress callback,
         // if it was the callback variable was reset and there is no need to request the next firmware packet
-        if (m_fw_callback == nullptr) {
+        return m_fw_callback != nullptr;
+    }
+
+    /// @brief Saves the progress of the update, so that it can be continued after a disconnect or reboot.
+    /// Nothing is saved if the firmware information is too long or the state of the hash can not be copied
+    /// @param written_bytes Amount of bytes that have been written into flash memory and hashed
+    inline void Save_Progress(const size_t& written_bytes) {
+        if (m_fw_title.size() >= OTA_RESUME_TITLE_SIZE || m_fw_version.size() >= OTA_RESUME_VERSION_SIZE || m_fw_checksum.size() >= OTA_RESUME_CHECKSUM_SIZE) {
           return;
         }
 
-        // Reset retries as the current chunk has been downloaded and handled successfully
+        OTA_Resume_State state = {};
+        state.hash_context_size = m_hash.save(state.hash_context, sizeof(state.hash_context));
+        if (state.hash_context_size == 0U) {
+          return;
+        }
+        state.layout = OTA_RESUME_STATE_LAYOUT;
+        state.checksum_algorithm = static_cast<uint8_t>(m_fw_checksum_algorithm);
+        state.chunk_size = m_fw_callback->Get_Chunk_Size();
+        state.fw_size = m_fw_size;
+        state.written_chunks = m_written_chunks;
+        strncpy(state.fw_title, m_fw_title.c_str(), sizeof(state.fw_title) - 1U);
+        strncpy(state.fw_version, m_fw_version.c_str(), sizeof(state.fw_version) - 1U);
+        strncpy(state.fw_checksum, m_fw_checksum.c_str(), sizeof(state.fw_checksum) - 1U);
+
+        if (OTA_Resume_Storage::save(state)) {
+          m_saved_bytes = written_bytes;
+        }
+    }
+
+    /// @brief Continues the update after the last saved chunk, if the saved progress belongs to the same firmware,
+    /// the state of the hash can be restored and the updater can continue writing into the same flash partition.
+    /// Progress that can not be used is removed, so the update starts from the beginning instead
+    /// @return Whether the update was resumed and the next chunks have been requested or not
+    inline bool Resume_Firmware_Update() {
+        OTA_Resume_State state;
+        if (!OTA_Resume_Storage::load(state)) {
+          return false;
+        }
+
+        const bool same_firmware = m_fw_title.compare(state.fw_title) == 0 && m_fw_version.compare(state.fw_version) == 0 && m_fw_checksum.compare(state.fw_checksum) == 0
+            && state.fw_size == m_fw_size && state.chunk_size == m_fw_callback->Get_Chunk_Size() && state.checksum_algorithm == static_cast<uint8_t>(m_fw_checksum_algorithm);
+        const size_t written_bytes = static_cast<size_t>(state.written_chunks) * state.chunk_size;
+        if (!same_firmware || state.written_chunks == 0U || state.written_chunks >= m_total_chunks) {
+          OTA_Resume_Storage::clear();
+          return false;
+        }
+
+        m_watchdog.detach();
+        m_hash.start(m_fw_checksum_algorithm);
+        if (!m_hash.restore(state.hash_context, state.hash_context_size) || !m_fw_updater->resume(m_fw_size, written_bytes)) {
+          OTA_Resume_Storage::clear();
+          return false;
+        }
+
+        char message[Helper::detectSize(RESUMING_FW_UPDATE, state.written_chunks, m_total_chunks)];
+        snprintf_P(message, sizeof(message), RESUMING_FW_UPDATE, state.written_chunks, m_total_chunks);
+        Logger::log(message);
+
+        m_written_chunks = state.written_chunks;
+        m_next_request = state.written_chunks;
+        m_saved_bytes = written_bytes;
+        for (Chunk_Slot& slot : m_chunks) {
+          slot.received = false;
+        }
         m_retries = m_fw_callback->Get_Chunk_Retries();
+        m_fw_callback->Call_Progress_Callback<Logger>(m_written_chunks, m_total_chunks);
         Request_Next_Firmware_Packet();
+        return true;
     }
 
-  private:
-    const OTA_Update_Callback *m_fw_callback;                                 // Callback method that contains configuration information, about the over the air update
-    std::function<bool(const size_t&)> m_publish_callback;                    // Callback that is used to request the firmware chunk of the firmware binary with the given chunk number
-    std::function<bool(const char *, const char *)> m_send_fw_state_callback; // Callback that is used to send information about the current state of the over the air update
-    std::function<bool(void)> m_finish_callback;                              // Callback that is called once the update has been finished and the user should be informed of the failure or success of the over the air update
-    size_t m_fw_size;                                                         // Total size of the firmware binary we will receive. Allows for a binary size of up to theoretically 4 GB
-    std::string m_fw_algorithm;                                               // String of the algorithm type used to hash the firmware binary
-    std::string m_fw_checksum;                                                // Checksum of the complete firmware binary, should be the same as the actually written data in the end
-    mbedtls_md_type_t m_fw_checksum_algorithm;                                // Algorithm type used to hash the firmware binary
-    IUpdater *m_fw_updater;                                                   // Interface implementation that writes received firmware binary data onto the given device
-    HashGenerator m_hash;                                                     // Class instance that allows to generate a hash from received firmware binary data
-    size_t m_total_chunks;                                                    // Total amount of chunks that need to be received to get the complete firmware binary
-    size_t m_requested_chunks;                                                // Amount of successfully requested and received firmware binary chunks
-    uint8_t m_retries;                                                        // Amount of request retries we attempt for each chunk, increasing makes the connection more stable
-    Callback_Watchdog m_watchdog;                                             // Class instances that allows to timeout if we do not receive a response for a requested chunk in the given time
-
-    /// @brief Restarts or starts the firmware update and its needed components and then requests the first firmware chunk
+    /// @brief Restarts or starts the firmware update and its needed components and then requests the first window of firmware chunks.
+    /// Any saved progress is removed, because the already written data is either from another firmware or could not be used
     inline void Request_First_Firmware_Packet() {
-        m_requested_chunks = 0U;
+        OTA_Resume_Storage::clear();
+        m_saved_bytes = 0U;
+        m_written_chunks = 0U;
+        m_next_request = 0U;
+        for (Chunk_Slot& slot : m_chunks) {
+          slot.received = false;
+        }
         m_retries = m_fw_callback->Get_Chunk_Retries();
         m_hash.start(m_fw_checksum_algorithm);
         m_watchdog.detach();
@@ -216,23 +432,69 @@ class OTA_Handler {
         Request_Next_Firmware_Packet();
     }
 
-    /// @brief Requests the next firmware chunk of the OTA firmware if there are any left
-    /// and starts the timer that ensures we request the same chunk again if we have not received a response yet
+    /// @brief Requests firmware chunks of the OTA firmware until the window is full or all chunks have been requested
+    /// and starts the timer that ensures we request chunks again if we have not received a response for them yet
     inline void Request_Next_Firmware_Packet() {
         // Check if we have already requested and handled the last remaining chunk
-        if (m_requested_chunks >= m_total_chunks) {
-            Finish_Firmware_Update();   
+        if (m_written_chunks >= m_total_chunks) {
+            m_watchdog.detach();
+            Finish_Firmware_Update();
             return;
         }
 
-        if (!m_publish_callback(m_requested_chunks)) {
+        while (m_next_request < m_total_chunks && m_next_request < m_written_chunks + m_window) {
+            Request_Chunk(m_next_request);
+            m_next_request++;
+        }
+        Start_Watchdog();
+    }
+
+    /// @brief Requests the given chunk and remembers the time of the request, the time is set even if publishing the request failed,
+    /// so that the chunk is requested again once it timed out, in hopes that publishing the request is then successful
+    /// @param chunk Index of the chunk that should be requested
+    inline void Request_Chunk(const size_t& chunk) {
+        Chunk_Slot& slot = m_chunks[chunk % m_window];
+        slot.received = false;
+        slot.requested_at = Get_Time_Us();
+        if (!m_publish_callback(chunk)) {
           Logger::log(UNABLE_TO_REQUEST_CHUNCKS);
           (void)m_send_fw_state_callback(FW_STATE_FAILED, UNABLE_TO_REQUEST_CHUNCKS);
         }
+    }
+
+    /// @brief Requests all outstanding chunks again whose response did not arrive in the configured timeout,
+    /// chunks that are still waiting in the reorder buffer or have been requested more recently are left alone
+    inline void Request_Timed_Out_Chunks() {
+        const uint64_t now = Get_Time_Us();
+        const uint64_t& timeout = m_fw_callback->Get_Timeout();
+        for (size_t chunk = m_written_chunks; chunk < m_next_request; chunk++) {
+            const Chunk_Slot& slot = m_chunks[chunk % m_window];
+            if (!slot.received && now - slot.requested_at >= timeout) {
+                Request_Chunk(chunk);
+            }
+        }
+        Start_Watchdog();
+    }
 
-        // Watchdog gets started no matter if publishing request was successful or not in hopes,
-        // that after the given timeout the callback calls this method again and can then publish the request successfully.
-        m_watchdog.once(m_fw_callback->Get_Timeout());
+    /// @brief Starts the watchdog for the outstanding chunk that was requested the longest time ago,
+    /// so that it fires as soon as the first outstanding chunk times out
+    inline void Start_Watchdog() {
+        m_watchdog.detach();
+        const uint64_t now = Get_Time_Us();
+        const uint64_t& timeout = m_fw_callback->Get_Timeout();
+        uint64_t remaining = timeout;
+        for (size_t chunk = m_written_chunks; chunk < m_next_request; chunk++) {
+            const Chunk_Slot& slot = m_chunks[chunk % m_window];
+            if (slot.received) {
+              continue;
+            }
+            const uint64_t elapsed = now - slot.requested_at;
+            const uint64_t left = (elapsed >= timeout) ? 1U : (timeout - elapsed);
+            if (left < remaining) {
+              remaining = left;
+            }
+        }
+        m_watchdog.once(remaining);
     }
 
     /// @brief Completes the firmware update, which consists of checking the complete hash of the firmware binary if the initally received value,
@@ -269,6 +531,8 @@ class OTA_Handler {
         Logger::log(FW_UPDATE_SUCCESS);
         (void)m_send_fw_state_callback(FW_STATE_UPDATING, nullptr);
 
+        Release_Reorder_Buffer();
+        OTA_Resume_Storage::clear();
         m_fw_callback->Call_Callback<Logger>(true);
         (void)m_finish_callback();
     }
@@ -278,6 +542,9 @@ class OTA_Handler {
     /// @param failure_response Possible response to a failure that the method should handle
     inline void Handle_Failure(const OTA_Failure_Response& failure_response) {
       if (m_retries <= 0) {
+          // Release the partially written update, so a later update does not start on top of an open one
+          m_fw_updater->reset();
+          Release_Reorder_Buffer();
           m_fw_callback->Call_Callback<Logger>(false);
           (void)m_finish_callback();
           return;
@@ -289,12 +556,13 @@ class OTA_Handler {
 
       switch (failure_response) {
         case OTA_Failure_Response::RETRY_CHUNK:
-          Request_Next_Firmware_Packet();
+          Request_Timed_Out_Chunks();
           break;
         case OTA_Failure_Response::RETRY_UPDATE:
           Request_First_Firmware_Packet();
           break;
         case OTA_Failure_Response::RETRY_NOTHING:
+          Release_Reorder_Buffer();
           m_fw_callback->Call_Callback<Logger>(false);
           (void)m_finish_callback();
           break;
@@ -304,7 +572,7 @@ class OTA_Handler {
       }
     }
 
-    /// @brief Callback that will be called if we did not receive the firmware chunk response in the given timeout time
+    /// @brief Callback that will be called if we did not receive the response for the oldest outstanding firmware chunk in the given timeout time
     inline void Handle_Request_Timeout() {
         Handle_Failure(OTA_Failure_Response::RETRY_CHUNK);
     }
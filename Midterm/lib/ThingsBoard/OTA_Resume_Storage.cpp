@@ -0,0 +1,75 @@
+// Header include.
+#include "OTA_Resume_Storage.h"
+
+#if THINGSBOARD_ENABLE_OTA
+
+#if THINGSBOARD_USE_ESP_NVS
+
+// Library includes.
+#include <nvs.h>
+#if THINGSBOARD_ENABLE_PROGMEM
+#include <pgmspace.h>
+#endif // THINGSBOARD_ENABLE_PROGMEM
+
+#if THINGSBOARD_ENABLE_PROGMEM
+constexpr char RESUME_NAMESPACE[] PROGMEM = "tb_ota";
+constexpr char RESUME_KEY[] PROGMEM = "progress";
+#else
+constexpr char RESUME_NAMESPACE[] = "tb_ota";
+constexpr char RESUME_KEY[] = "progress";
+#endif // THINGSBOARD_ENABLE_PROGMEM
+
+bool OTA_Resume_Storage::load(OTA_Resume_State& state) {
+    nvs_handle_t handle;
+    if (nvs_open(RESUME_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t size = sizeof(state);
+    const esp_err_t error = nvs_get_blob(handle, RESUME_KEY, &state, &size);
+    nvs_close(handle);
+    return error == ESP_OK && size == sizeof(state) && state.layout == OTA_RESUME_STATE_LAYOUT;
+}
+
+bool OTA_Resume_Storage::save(const OTA_Resume_State& state) {
+    nvs_handle_t handle;
+    if (nvs_open(RESUME_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return false;
+    }
+    esp_err_t error = nvs_set_blob(handle, RESUME_KEY, &state, sizeof(state));
+    if (error == ESP_OK) {
+        error = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return error == ESP_OK;
+}
+
+void OTA_Resume_Storage::clear() {
+    nvs_handle_t handle;
+    if (nvs_open(RESUME_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_erase_key(handle, RESUME_KEY) == ESP_OK) {
+        (void)nvs_commit(handle);
+    }
+    nvs_close(handle);
+}
+
+#else
+
+bool OTA_Resume_Storage::load(OTA_Resume_State& state) {
+    (void)state;
+    return false;
+}
+
+bool OTA_Resume_Storage::save(const OTA_Resume_State& state) {
+    (void)state;
+    return false;
+}
+
+void OTA_Resume_Storage::clear() {
+    // Nothing to do
+}
+
+#endif // THINGSBOARD_USE_ESP_NVS
+
+#endif // THINGSBOARD_ENABLE_OTA
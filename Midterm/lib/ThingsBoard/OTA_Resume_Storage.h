@@ -0,0 +1,61 @@
+#ifndef OTA_Resume_Storage_h
+#define OTA_Resume_Storage_h
+
+// Local include.
+#include "Configuration.h"
+
+#if THINGSBOARD_ENABLE_OTA
+
+// Library include.
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Layout version of the persisted OTA_Resume_State, has to be increased whenever the structure changes,
+// so that progress saved by a previous firmware is discarded instead of being misread
+constexpr uint8_t OTA_RESUME_STATE_LAYOUT = 1U;
+// Maximum lengths including the null terminator, firmware that does not fit is downloaded without saving its progress
+constexpr size_t OTA_RESUME_TITLE_SIZE = 32U;
+constexpr size_t OTA_RESUME_VERSION_SIZE = 32U;
+constexpr size_t OTA_RESUME_CHECKSUM_SIZE = 129U;
+// Large enough for the mbedtls MD5, SHA256 and SHA512 contexts, including the additional fields of the ESP hardware accelerated implementations
+constexpr size_t OTA_RESUME_HASH_CONTEXT_SIZE = 256U;
+
+
+/// @brief Progress of a firmware update that is persisted while downloading, allows to continue the same update after a disconnect or reboot.
+/// The firmware is identified by its title, version, checksum and size, if any of them differ the saved progress belongs to another firmware and is not used
+struct OTA_Resume_State {
+    uint8_t layout;                                      // Layout version the state was saved with, compared against OTA_RESUME_STATE_LAYOUT
+    uint8_t checksum_algorithm;                          // Algorithm type used to hash the firmware binary
+    uint16_t chunk_size;                                 // Size of the chunks the firmware binary was split into
+    uint32_t fw_size;                                    // Total size of the firmware binary
+    uint32_t written_chunks;                             // Amount of chunks that were written into flash memory and hashed
+    uint16_t hash_context_size;                          // Amount of bytes used in hash_context
+    char fw_title[OTA_RESUME_TITLE_SIZE];                // Title of the firmware that is downloaded
+    char fw_version[OTA_RESUME_VERSION_SIZE];            // Version of the firmware that is downloaded
+    char fw_checksum[OTA_RESUME_CHECKSUM_SIZE];          // Expected checksum of the complete firmware binary
+    uint8_t hash_context[OTA_RESUME_HASH_CONTEXT_SIZE];  // Intermediate state of the hash over the written chunks
+};
+
+
+/// @brief Static helper class that persists the OTA_Resume_State into the non volatile storage (https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/storage/nvs_flash.html),
+/// the storage has to be initalized with nvs_flash_init() before, which Arduino and the Wi-Fi driver already do. If the nvs header does not exist, nothing is persisted
+class OTA_Resume_Storage {
+  public:
+    /// @brief Loads the previously saved progress
+    /// @param state Output state the saved progress is copied into
+    /// @return Whether progress with the current layout was saved or not
+    static bool load(OTA_Resume_State& state);
+
+    /// @brief Saves the given progress, replacing any previously saved one
+    /// @param state Progress that should be saved
+    /// @return Whether saving the progress was successful or not
+    static bool save(const OTA_Resume_State& state);
+
+    /// @brief Removes the saved progress, once the update finished or has to start from the beginning
+    static void clear();
+};
+
+#endif // THINGSBOARD_ENABLE_OTA
+
+#endif // OTA_Resume_Storage_h
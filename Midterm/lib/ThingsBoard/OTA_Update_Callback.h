@@ -29,10 +29,12 @@ constexpr char OTA_CB_IS_NULL[] = "OTA update callback is NULL";
 constexpr uint8_t CHUNK_RETRIES PROGMEM = 12U;
 constexpr uint16_t CHUNK_SIZE PROGMEM = (4U * 1024U);
 constexpr uint64_t REQUEST_TIMEOUT PROGMEM = (5U * 1000U * 1000U);
+constexpr uint8_t CHUNK_WINDOW PROGMEM = 4U;
 #else
 constexpr uint8_t CHUNK_RETRIES = 12U;
 constexpr uint16_t CHUNK_SIZE = (4U * 1024U);
 constexpr uint64_t REQUEST_TIMEOUT = (5U * 1000U * 1000U);
+constexpr uint8_t CHUNK_WINDOW = 4U;
 #endif // THINGSBOARD_ENABLE_PROGMEM
 
 
@@ -62,7 +64,9 @@ class OTA_Update_Callback : public Callback<void, const bool&> {
     // because the whole chunk is saved into the heap before it can be processed and is then erased again after it has been used
     /// @param timeout Maximum amount of time in microseconds for the OTA firmware update for each seperate chunk,
     /// until that chunk counts as a timeout, retries is then subtraced by one and the download is retried
-    OTA_Update_Callback(function endCb, const char *currFwTitle, const char *currFwVersion, IUpdater *updater, const uint8_t &chunkRetries = CHUNK_RETRIES, const uint16_t &chunkSize = CHUNK_SIZE, const uint64_t &timeout = REQUEST_TIMEOUT);
+    /// @param windowSize Amount of chunks that are requested at once without waiting for the previous ones to arrive,
+    /// increasing hides the round trip time of high latency connections, but every chunk after the first one needs chunkSize bytes of heap memory to reorder it
+    OTA_Update_Callback(function endCb, const char *currFwTitle, const char *currFwVersion, IUpdater *updater, const uint8_t &chunkRetries = CHUNK_RETRIES, const uint16_t &chunkSize = CHUNK_SIZE, const uint64_t &timeout = REQUEST_TIMEOUT, const uint8_t &windowSize = CHUNK_WINDOW);
 
     /// @brief Constructs callbacks that will be called when the OTA firmware data,
     /// has been completly sent by the cloud, received by the client and written to the flash partition as well as callback
@@ -80,7 +84,9 @@ class OTA_Update_Callback : public Callback<void, const bool&> {
     // because the whole chunk is saved into the heap before it can be processed and is then erased again after it has been used
     /// @param timeout Maximum amount of time in microseconds for the OTA firmware update for each seperate chunk,
     /// until that chunk counts as a timeout, retries is then subtraced by one and the download is retried
-    OTA_Update_Callback(progressFn progressCb, function endCb, const char *currFwTitle, const char *currFwVersion, IUpdater *updater, const uint8_t &chunkRetries = CHUNK_RETRIES, const uint16_t &chunkSize = CHUNK_SIZE, const uint64_t &timeout = REQUEST_TIMEOUT);
+    /// @param windowSize Amount of chunks that are requested at once without waiting for the previous ones to arrive,
+    /// increasing hides the round trip time of high latency connections, but every chunk after the first one needs chunkSize bytes of heap memory to reorder it
+    OTA_Update_Callback(progressFn progressCb, function endCb, const char *currFwTitle, const char *currFwVersion, IUpdater *updater, const uint8_t &chunkRetries = CHUNK_RETRIES, const uint16_t &chunkSize = CHUNK_SIZE, const uint64_t &timeout = REQUEST_TIMEOUT, const uint8_t &windowSize = CHUNK_WINDOW);
 
     /// @brief Calls the progress callback that was subscribed, when this class instance was initally created
     /// @tparam Logger Logging class that should be used to print messages generated by internal processes
@@ -164,6 +170,17 @@ class OTA_Update_Callback : public Callback<void, const bool&> {
     /// @param timeout_microseconds Timeout time until we expect a response from the server
     void Set_Timeout(const uint64_t &timeout_microseconds);
 
+    /// @brief Gets the amount of chunks that are requested at once, without waiting for the previous ones to arrive first.
+    /// Chunks are still written into flash memory and hashed strictly in order, chunks that arrive early are held back until the missing ones arrived
+    /// @return Amount of chunk requests that are outstanding at once
+    const uint8_t& Get_Window_Size() const;
+
+    /// @brief Sets the amount of chunks that are requested at once, without waiting for the previous ones to arrive first.
+    /// A window size of 1 requests every chunk only once the previous one has been written, increasing it requires additional heap memory
+    /// of the chunk size for every chunk that might arrive before the one that has to be written next
+    /// @param windowSize Amount of chunk requests that are outstanding at once
+    void Set_Window_Size(const uint8_t &windowSize);
+
   private:
     progressFn      m_progressCb;    // Progress callback to call
     const char      *m_fwTitel;      // Current firmware title of device
@@ -172,6 +189,7 @@ class OTA_Update_Callback : public Callback<void, const bool&> {
     uint8_t         m_retries;       // Maximum amount of retries for a single chunk to be downloaded and flashes successfully
     uint16_t        m_size;          // Size of chunks the firmware data will be split into
     uint64_t        m_timeout;       // How long we wait for each chunck to arrive before declaring it as failed
+    uint8_t         m_window;        // Amount of chunks requested at once, before the previous ones have arrived
 };
 
 #endif // THINGSBOARD_ENABLE_OTA
@@ -18,6 +18,9 @@
 #if THINGSBOARD_ENABLE_STREAM_UTILS
 #include <StreamUtils.h>
 #endif // THINGSBOARD_ENABLE_STREAM_UTILS
+#if THINGSBOARD_USE_ESP_TIMER
+#include <esp_timer.h>
+#endif // THINGSBOARD_USE_ESP_TIMER
 
 
 /// ---------------------------------
@@ -32,6 +35,40 @@ constexpr char ATTRIBUTE_TOPIC[] = "v1/devices/me/attributes";
 constexpr char TELEMETRY_TOPIC[] = "v1/devices/me/telemetry";
 #endif // THINGSBOARD_ENABLE_PROGMEM
 
+// Gateway topics.
+#if THINGSBOARD_ENABLE_PROGMEM
+constexpr char GATEWAY_CONNECT_TOPIC[] PROGMEM = "v1/gateway/connect";
+constexpr char GATEWAY_DISCONNECT_TOPIC[] PROGMEM = "v1/gateway/disconnect";
+constexpr char GATEWAY_TELEMETRY_TOPIC[] PROGMEM = "v1/gateway/telemetry";
+constexpr char GATEWAY_ATTRIBUTES_TOPIC[] PROGMEM = "v1/gateway/attributes";
+#else
+constexpr char GATEWAY_CONNECT_TOPIC[] = "v1/gateway/connect";
+constexpr char GATEWAY_DISCONNECT_TOPIC[] = "v1/gateway/disconnect";
+constexpr char GATEWAY_TELEMETRY_TOPIC[] = "v1/gateway/telemetry";
+constexpr char GATEWAY_ATTRIBUTES_TOPIC[] = "v1/gateway/attributes";
+#endif // THINGSBOARD_ENABLE_PROGMEM
+
+// Gateway data keys.
+#if THINGSBOARD_ENABLE_PROGMEM
+constexpr char GATEWAY_DEVICE_KEY[] PROGMEM = "device";
+constexpr char GATEWAY_TYPE_KEY[] PROGMEM = "type";
+#else
+constexpr char GATEWAY_DEVICE_KEY[] = "device";
+constexpr char GATEWAY_TYPE_KEY[] = "type";
+#endif // THINGSBOARD_ENABLE_PROGMEM
+
+// Telemetry batch keys.
+#if THINGSBOARD_ENABLE_PROGMEM
+constexpr char TS_KEY[] PROGMEM = "ts";
+constexpr char VALUES_KEY[] PROGMEM = "values";
+#else
+constexpr char TS_KEY[] = "ts";
+constexpr char VALUES_KEY[] = "values";
+#endif // THINGSBOARD_ENABLE_PROGMEM
+
+// Sub-device indices in the gateway telemetry batch are stored in a single byte.
+constexpr size_t GATEWAY_MAX_DEVICES = 255U;
+
 // RPC topics.
 #if THINGSBOARD_ENABLE_PROGMEM
 constexpr char RPC_SUBSCRIBE_TOPIC[] PROGMEM = "v1/devices/me/rpc/request/+";
@@ -49,6 +86,23 @@ constexpr char RPC_RESPONSE_TOPIC[] = "v1/devices/me/rpc/response";
 constexpr char RPC_SEND_RESPONSE_TOPIC[] = "v1/devices/me/rpc/response/%u";
 #endif // THINGSBOARD_ENABLE_PROGMEM
 
+// Slots of the open addressing table that finds server-side RPC methods by the hash of their name, has to be a power of 2.
+// At most three quarters of them are used, to keep the probe sequences short.
+constexpr size_t RPC_METHOD_TABLE_SIZE = 64U;
+constexpr size_t RPC_METHOD_TABLE_CAPACITY = RPC_METHOD_TABLE_SIZE * 3U / 4U;
+static_assert((RPC_METHOD_TABLE_SIZE & (RPC_METHOD_TABLE_SIZE - 1U)) == 0U, "RPC method table size has to be a power of 2");
+
+// Slots for pending client-side RPC requests, a request is stored in the slot given by its id modulo the amount of slots.
+constexpr size_t RPC_REQUEST_SLOTS = 16U;
+// Time in milliseconds after which a pending client-side RPC request without a response is given up and its slot freed.
+constexpr uint64_t RPC_REQUEST_TIMEOUT_MS = 30000U;
+
+#if THINGSBOARD_ENABLE_DYNAMIC
+// Initial size of the JsonDocument every received json message is parsed into. The document is kept between messages
+// and doubles whenever a message does not fit, so it settles at the size of the largest message received so far.
+constexpr size_t INBOUND_JSON_INITIAL_SIZE = JSON_OBJECT_SIZE(Default_Fields_Amt) + Default_Payload;
+#endif // THINGSBOARD_ENABLE_DYNAMIC
+
 // Firmware topics.
 #if THINGSBOARD_ENABLE_PROGMEM
 constexpr char FIRMWARE_RESPONSE_TOPIC[] PROGMEM = "v2/fw/response/0/chunk";
@@ -74,6 +128,39 @@ constexpr char PROV_RESPONSE_TOPIC[] PROGMEM = "/provision/response";
 constexpr char PROV_RESPONSE_TOPIC[] = "/provision/response";
 #endif // THINGSBOARD_ENABLE_PROGMEM
 
+/// @brief Process methods a received message can be routed to, selected by the topic it was received over
+enum class Topic_Route : const uint8_t {
+  RPC_RESPONSE, // Response to a client-side RPC request
+  RPC_REQUEST, // Server-side RPC request
+  ATTRIBUTE_RESPONSE, // Response to a client-side or shared attribute request
+  ATTRIBUTE, // Shared attribute update
+  PROVISION_RESPONSE, // Response to a device provisioning request
+  FIRMWARE_RESPONSE // Binary firmware chunk
+};
+
+/// @brief Known topic prefix and the route of the messages received over it
+struct Topic_Route_Entry {
+  const char *prefix; // Topic prefix, might be stored in flash memory
+  size_t length; // Length of the prefix, a received topic has to end after it or continue with a "/"
+  Topic_Route route; // Process method the message is routed to
+  bool json; // Whether the payload has to be deserialized into json before it is processed
+};
+
+// Every topic prefix we subscribe to, the order does not matter because the longest matching prefix is chosen.
+constexpr Topic_Route_Entry TOPIC_ROUTES[] = {
+  { RPC_RESPONSE_TOPIC, sizeof(RPC_RESPONSE_TOPIC) - 1U, Topic_Route::RPC_RESPONSE, true },
+  { RPC_REQUEST_TOPIC, sizeof(RPC_REQUEST_TOPIC) - 1U, Topic_Route::RPC_REQUEST, true },
+  { ATTRIBUTE_RESPONSE_TOPIC, sizeof(ATTRIBUTE_RESPONSE_TOPIC) - 1U, Topic_Route::ATTRIBUTE_RESPONSE, true },
+  { ATTRIBUTE_TOPIC, sizeof(ATTRIBUTE_TOPIC) - 1U, Topic_Route::ATTRIBUTE, true },
+  { PROV_RESPONSE_TOPIC, sizeof(PROV_RESPONSE_TOPIC) - 1U, Topic_Route::PROVISION_RESPONSE, true },
+#if THINGSBOARD_ENABLE_OTA
+  // Contains only firmware bytes that are written directly into flash memory
+  { FIRMWARE_RESPONSE_TOPIC, sizeof(FIRMWARE_RESPONSE_TOPIC) - 1U, Topic_Route::FIRMWARE_RESPONSE, false },
+#endif // THINGSBOARD_ENABLE_OTA
+};
+constexpr size_t TOPIC_ROUTES_AMOUNT = sizeof(TOPIC_ROUTES) / sizeof(TOPIC_ROUTES[0]);
+static_assert(TOPIC_ROUTES_AMOUNT <= 8U, "Candidate routes are tracked in an 8 bit mask");
+
 // Default login data.
 #if THINGSBOARD_ENABLE_PROGMEM
 constexpr char PROV_ACCESS_TOKEN[] PROGMEM = "provision";
@@ -121,16 +208,22 @@ constexpr char NUMBER_PRINTF[] PROGMEM = "%u";
 #endif // THINGSBOARD_ENABLE_OTA
 #if !THINGSBOARD_ENABLE_DYNAMIC
 constexpr char MAX_RPC_EXCEEDED[] PROGMEM = "Too many server-side RPC subscriptions, increase MaxFieldsAmt or unsubscribe";
-constexpr char MAX_RPC_REQUEST_EXCEEDED[] PROGMEM = "Too many client-side RPC subscriptions, increase MaxFieldsAmt or unsubscribe";
 constexpr char MAX_SHARED_ATT_UPDATE_EXCEEDED[] PROGMEM = "Too many shared attribute update callback subscriptions, increase MaxFieldsAmt or unsubscribe";
 constexpr char MAX_SHARED_ATT_REQUEST_EXCEEDED[] PROGMEM = "Too many shared attribute request callback subscriptions, increase MaxFieldsAmt";
 #else
-constexpr char COLON PROGMEM = ':';
+constexpr char INBOUND_JSON_GROWN[] PROGMEM = "Received message did not fit, grew the reused JsonDocument to (%u) bytes";
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
 constexpr char COMMA PROGMEM = ',';
+constexpr char RPC_METHOD_TABLE_FULL[] PROGMEM = "Too many server-side RPC subscriptions, increase RPC_METHOD_TABLE_SIZE or unsubscribe";
+constexpr char RPC_REQUEST_SLOTS_FULL[] PROGMEM = "Too many pending client-side RPC requests, dropping the oldest one, increase RPC_REQUEST_SLOTS";
+constexpr char RPC_REQUEST_EXPIRED[] PROGMEM = "Client-side RPC request with id (%u) received no response in time and is dropped";
 constexpr char NO_KEYS_TO_REQUEST[] PROGMEM = "No keys to request were given";
 constexpr char RPC_METHOD_NULL[] PROGMEM = "RPC methodName is NULL";
 constexpr char SUBSCRIBE_TOPIC_FAILED[] PROGMEM = "Subscribing the given topic failed";
+constexpr char BATCH_NOT_CONFIGURED[] PROGMEM = "Telemetry batching is not configured, call setTelemetryBatching first";
+constexpr char GATEWAY_DEVICE_UNKNOWN[] PROGMEM = "Sub-device (%s) is not connected, call Gateway_Connect_Device first";
+constexpr char GATEWAY_TOO_MANY_DEVICES[] PROGMEM = "Too many sub-devices connected through the gateway";
+constexpr char TELEMETRY_NOT_DELIVERED[] PROGMEM = "Telemetry batch with message id (%u) was not acknowledged by the broker and is lost";
 #if THINGSBOARD_ENABLE_DEBUG
 constexpr char NO_RPC_PARAMS_PASSED[] PROGMEM = "No parameters passed with RPC, passing null JSON";
 constexpr char NOT_FOUND_ATT_UPDATE[] PROGMEM = "Shared attribute update key not found";
@@ -153,16 +246,22 @@ constexpr char NUMBER_PRINTF[] = "%u";
 #endif // THINGSBOARD_ENABLE_OTA
 #if !THINGSBOARD_ENABLE_DYNAMIC
 constexpr char MAX_RPC_EXCEEDED[] = "Too many server-side RPC subscriptions, increase MaxFieldsAmt or unsubscribe";
-constexpr char MAX_RPC_REQUEST_EXCEEDED[] = "Too many client-side RPC subscriptions, increase MaxFieldsAmt or unsubscribe";
 constexpr char MAX_SHARED_ATT_UPDATE_EXCEEDED[] = "Too many shared attribute update callback subscriptions, increase MaxFieldsAmt or unsubscribe";
 constexpr char MAX_SHARED_ATT_REQUEST_EXCEEDED[] = "Too many shared attribute request callback subscriptions, increase MaxFieldsAmt";
 #else
-constexpr char COLON = ':';
+constexpr char INBOUND_JSON_GROWN[] = "Received message did not fit, grew the reused JsonDocument to (%u) bytes";
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
 constexpr char COMMA = ',';
+constexpr char RPC_METHOD_TABLE_FULL[] = "Too many server-side RPC subscriptions, increase RPC_METHOD_TABLE_SIZE or unsubscribe";
+constexpr char RPC_REQUEST_SLOTS_FULL[] = "Too many pending client-side RPC requests, dropping the oldest one, increase RPC_REQUEST_SLOTS";
+constexpr char RPC_REQUEST_EXPIRED[] = "Client-side RPC request with id (%u) received no response in time and is dropped";
 constexpr char NO_KEYS_TO_REQUEST[] = "No keys to request were given";
 constexpr char RPC_METHOD_NULL[] = "RPC methodName is NULL";
 constexpr char SUBSCRIBE_TOPIC_FAILED[] = "Subscribing the given topic failed";
+constexpr char BATCH_NOT_CONFIGURED[] = "Telemetry batching is not configured, call setTelemetryBatching first";
+constexpr char GATEWAY_DEVICE_UNKNOWN[] = "Sub-device (%s) is not connected, call Gateway_Connect_Device first";
+constexpr char GATEWAY_TOO_MANY_DEVICES[] = "Too many sub-devices connected through the gateway";
+constexpr char TELEMETRY_NOT_DELIVERED[] = "Telemetry batch with message id (%u) was not acknowledged by the broker and is lost";
 #if THINGSBOARD_ENABLE_DEBUG
 constexpr char NO_RPC_PARAMS_PASSED[] = "No parameters passed with RPC, passing null JSON";
 constexpr char NOT_FOUND_ATT_UPDATE[] = "Shared attribute update key not found";
@@ -335,12 +434,35 @@ class ThingsBoardSized {
       : m_client(client)
       , m_max_stack(maxStackSize)
       , m_buffering_size(bufferingSize)
+      , m_batch_buffer(nullptr)
+      , m_batch_capacity(0U)
+      , m_batch_length(0U)
+      , m_batch_count(0U)
+      , m_batch_max_samples(0U)
+      , m_batch_max_age(0U)
+      , m_batch_started(0U)
+      , m_batch_qos(0U)
+      , m_delivery_callback(nullptr)
+      , m_gateway_devices()
+      , m_gateway_records(nullptr)
+      , m_gateway_records_capacity(0U)
+      , m_gateway_records_length(0U)
+      , m_gateway_count(0U)
       , m_rpc_callbacks()
-      , m_rpc_request_callbacks()
+      , m_rpc_method_table()
+      , m_rpc_request_slots()
+      , m_rpc_request_taken()
+      , m_rpc_request_count(0U)
       , m_shared_attribute_update_callbacks()
       , m_attribute_request_callbacks()
       , m_provision_callback()
       , m_request_id(0U)
+      , m_receiving(false)
+#if THINGSBOARD_ENABLE_DYNAMIC
+      , m_inbound_json(INBOUND_JSON_INITIAL_SIZE)
+#else
+      , m_inbound_json()
+#endif // THINGSBOARD_ENABLE_DYNAMIC
 #if THINGSBOARD_ENABLE_OTA
       , m_fw_callback(nullptr)
       , m_previous_buffer_size(0U)
@@ -353,8 +475,10 @@ class ThingsBoardSized {
       // Initalize callback.
 #if THINGSBOARD_ENABLE_STL
       m_client.set_callback(std::bind(&ThingsBoardSized::onMQTTMessage, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+      m_client.set_delivery_callback(std::bind(&ThingsBoardSized::onMQTTDelivery, this, std::placeholders::_1, std::placeholders::_2));
 #else
       m_client.set_callback(ThingsBoardSized::onStaticMQTTMessage);
+      m_client.set_delivery_callback(ThingsBoardSized::onStaticMQTTDelivery);
       m_subscribedInstance = this;
 #endif // THINGSBOARD_ENABLE_STL
 
@@ -365,7 +489,12 @@ class ThingsBoardSized {
 
     /// @brief Destructor
     inline ~ThingsBoardSized() {
-      // Nothing to do
+      // Ensure the memory of the telemetry batch is released, any samples not yet flushed are discarded
+      delete[] m_batch_buffer;
+      m_batch_buffer = nullptr;
+      // Same for the gateway telemetry batch
+      delete[] m_gateway_records;
+      m_gateway_records = nullptr;
     }
 
     /// @brief Gets the currently connected MQTT Client implementation as a reference.
@@ -464,9 +593,15 @@ class ThingsBoardSized {
       return m_client.connected();
     }
 
-    /// @brief Receives / sends any outstanding messages from and to the MQTT broker
+    /// @brief Receives / sends any outstanding messages from and to the MQTT broker,
+    /// additionally flushes the telemetry batch if its oldest sample is older than the configured maximum age
+    /// and drops client-side RPC requests that did not receive a response within RPC_REQUEST_TIMEOUT_MS
     /// @return Whether sending or receiving the oustanding the messages was successful or not
     inline bool loop() {
+      if (m_batch_count != 0U && m_batch_max_age != 0U && Get_Time_Ms() - m_batch_started >= m_batch_max_age) {
+        flushTelemetryBatch();
+      }
+      Expire_RPC_Requests();
       return m_client.loop();
     }
 
@@ -495,6 +630,15 @@ class ThingsBoardSized {
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
       bool result = false;
 
+      // Serialize straight into the packet buffer of the client if it supports that, which needs neither a copy nor an allocation.
+      // One spare byte is required, so the payload can be null terminated to log it in debug builds
+      // Not while a received message is processed, because the source might reference strings of that message that live in the same buffer
+      size_t capacity = 0U;
+      uint8_t *payload = nullptr;
+      if (!m_receiving && jsonSize <= m_client.get_buffer_size()) {
+        payload = m_client.begin_buffered_publish(topic, capacity);
+      }
+
 #if THINGSBOARD_ENABLE_STREAM_UTILS
       // Check if the size of the given message would be too big for the actual client,
       // if it is utilize the serialize json work around, so that the internal client buffer can be circumvented
@@ -506,11 +650,26 @@ class ThingsBoardSized {
 #endif // THINGSBOARD_ENABLE_DEBUG
         result = Serialize_Json(topic, source, jsonSize);
       }
-      // Check if the remaining stack size of the current task would overflow the stack,
-      // if it would allocate the memory on the heap instead to ensure no stack overflow occurs
       else
 #endif // THINGSBOARD_ENABLE_STREAM_UTILS
-      if (getMaximumStackSize() < jsonSize) {
+      if (payload != nullptr && jsonSize <= capacity) {
+        MQTT_Buffer_Writer writer(payload, capacity);
+        serializeJson(source, writer);
+        if (writer.overflowed() || writer.length() < jsonSize - 1) {
+          Logger::log(UNABLE_TO_SERIALIZE_JSON);
+          return result;
+        }
+#if THINGSBOARD_ENABLE_DEBUG
+        payload[writer.length()] = '\0';
+        char message[JSON_STRING_SIZE(strlen(SEND_MESSAGE)) + JSON_STRING_SIZE(strlen(topic)) + jsonSize];
+        snprintf_P(message, sizeof(message), SEND_MESSAGE, topic, reinterpret_cast<const char*>(payload));
+        Logger::log(message);
+#endif // THINGSBOARD_ENABLE_DEBUG
+        result = m_client.end_buffered_publish(writer.length());
+      }
+      // Check if the remaining stack size of the current task would overflow the stack,
+      // if it would allocate the memory on the heap instead to ensure no stack overflow occurs
+      else if (getMaximumStackSize() < jsonSize) {
         char* json = new char[jsonSize];
         if (serializeJson(source, json, jsonSize) < jsonSize - 1) {
           Logger::log(UNABLE_TO_SERIALIZE_JSON);
@@ -698,6 +857,346 @@ class ThingsBoardSized {
       return Send_Json(TELEMETRY_TOPIC, source, jsonSize);
     }
 
+    //----------------------------------------------------------------------------
+    // Batched telemetry API
+
+    /// @brief Enables batching of timestamped telemetry, samples passed to sendTelemetryBatched() are then collected
+    /// and sent in the ThingsBoard array form [{"ts":...,"values":{...}}, ...] with a single publish.
+    /// The batch is flushed once it contains maxSamples entries, once its oldest entry is older than maxAgeMs (checked in loop()),
+    /// once the next entry would not fit into the batch memory anymore or explicitly with flushTelemetryBatch().
+    /// With a quality of service of 0 the batch is published in segments straight from the batch memory, so it may be bigger than the buffer of the underlying client.
+    /// With a quality of service of 1 the client keeps a copy of every batch until the broker acknowledges it and resends it if needed,
+    /// the outcome is reported to the callback set with setTelemetryDeliveryCallback(). If the client can not keep another unacknowledged batch
+    /// at the moment, the samples stay in the batch and are sent with the next flush.
+    /// See https://thingsboard.io/docs/reference/mqtt-api/#telemetry-upload-api for more information
+    /// @param maxSamples Amount of samples after which the batch is sent, 0 disables batching and frees the batch memory
+    /// @param maxAgeMs Maximum time in milliseconds a sample stays in the batch before it is sent, 0 means samples are only sent because of size
+    /// @param batchSize Size of the batch memory in bytes, which is allocated once, 0 uses the current buffer size of the client, default = 0
+    /// @param qos Quality of service the batches are published with, 0 or 1, default = 0
+    /// @return Whether enabling or disabling batching was successful or not
+    inline bool setTelemetryBatching(const size_t& maxSamples, const uint64_t& maxAgeMs, const size_t& batchSize = 0U, const uint8_t& qos = 0U) {
+      if (qos > 1U) {
+        return false;
+      }
+      // Send whatever was collected with the previous configuration first
+      flushTelemetryBatch();
+      m_batch_max_samples = maxSamples;
+      m_batch_max_age = maxAgeMs;
+      m_batch_qos = qos;
+
+      const size_t currentBufferSize = (batchSize != 0U) ? batchSize : m_client.get_buffer_size();
+      if (maxSamples == 0U || m_batch_capacity != currentBufferSize) {
+        delete[] m_batch_buffer;
+        m_batch_buffer = nullptr;
+        m_batch_capacity = 0U;
+        m_batch_length = 0U;
+        m_batch_count = 0U;
+      }
+      if (maxSamples == 0U || m_batch_buffer != nullptr) {
+        return true;
+      }
+      m_batch_buffer = new char[currentBufferSize];
+      m_batch_capacity = currentBufferSize;
+      return true;
+    }
+
+    /// @brief Adds a timestamped telemetry sample with the given key and value of the given type to the batch.
+    /// See https://thingsboard.io/docs/user-guide/telemetry/ for more information
+    /// @tparam T Type of the passed value
+    /// @param key Key of the key value pair we want to send
+    /// @param value Value of the key value pair we want to send
+    /// @param timestamp Unix time in milliseconds the sample was taken at, 0 if unknown (the server time of arrival is used instead)
+    /// @return Whether adding the sample, and sending the batch if that was required, was successful or not
+    template<typename T>
+    inline bool sendTelemetryDataBatched(const char *key, T value, const uint64_t& timestamp) {
+      const Telemetry data(key, value);
+      return sendTelemetryBatched(&data, 1U, timestamp);
+    }
+
+    /// @brief Adds one timestamped sample, consisting of multiple key value pairs, to the batch.
+    /// The sample is serialized straight into the batch, so the passed data does not need to outlive this call.
+    /// See https://thingsboard.io/docs/user-guide/telemetry/ for more information
+    /// @param data Array containing all the key value pairs of the sample
+    /// @param data_count Amount of data entries in the array that we want to send
+    /// @param timestamp Unix time in milliseconds the sample was taken at, 0 if unknown (the server time of arrival is used instead)
+    /// @return Whether adding the sample, and sending the batch if that was required, was successful or not
+    inline bool sendTelemetryBatched(const Telemetry *data, size_t data_count, const uint64_t& timestamp) {
+      if (m_batch_buffer == nullptr) {
+        Logger::log(BATCH_NOT_CONFIGURED);
+        return false;
+      }
+#if THINGSBOARD_ENABLE_DYNAMIC
+      // String are const char* and therefore stored as a pointer --> zero copy, meaning the size for the strings is 0 bytes,
+      // Data structure size depends on the amount of key value pairs passed + the ts and values keys of the entry.
+      // See https://arduinojson.org/v6/assistant/ for more information on the needed size for the JsonDocument
+      const size_t dataStructureMemoryUsage = JSON_OBJECT_SIZE(2U) + JSON_OBJECT_SIZE(data_count);
+      TBJsonDocument jsonBuffer(dataStructureMemoryUsage);
+#else
+      if (MaxFieldsAmt < data_count) {
+        char message[Helper::detectSize(TOO_MANY_JSON_FIELDS, data_count, MaxFieldsAmt)];
+        snprintf_P(message, sizeof(message), TOO_MANY_JSON_FIELDS, data_count, MaxFieldsAmt);
+        Logger::log(message);
+        return false;
+      }
+      StaticJsonDocument<JSON_OBJECT_SIZE(2U) + JSON_OBJECT_SIZE(MaxFieldsAmt)> jsonBuffer;
+#endif // !THINGSBOARD_ENABLE_DYNAMIC
+
+      const JsonObject entry = jsonBuffer.template to<JsonObject>();
+      if (!Serialize_Telemetry_Entry(entry, data, data_count, timestamp)) {
+        return false;
+      }
+      return Append_Telemetry_Batch(entry);
+    }
+
+    /// @brief Sends all samples currently collected in the telemetry batch with a single publish
+    /// @return Whether sending the batch was successful or not, if it was not the samples are kept and sent with the next flush
+    inline bool flushTelemetryBatch() {
+      if (m_batch_count == 0U) {
+        return true;
+      }
+#if THINGSBOARD_ENABLE_DEBUG
+      char message[JSON_STRING_SIZE(strlen(SEND_MESSAGE)) + JSON_STRING_SIZE(strlen(TELEMETRY_TOPIC)) + m_batch_length];
+      snprintf_P(message, sizeof(message), SEND_MESSAGE, TELEMETRY_TOPIC, m_batch_buffer);
+      Logger::log(message);
+#endif // THINGSBOARD_ENABLE_DEBUG
+      if (m_batch_qos != 0U) {
+        // The client copies the message to be able to resend it, so it has to be contiguous,
+        // Append_Telemetry_Batch() always leaves room for the closing bracket after the entries
+        m_batch_buffer[m_batch_length] = ']';
+        if (!m_client.publish(TELEMETRY_TOPIC, reinterpret_cast<const uint8_t*>(m_batch_buffer), m_batch_length + 1U, m_batch_qos, nullptr)) {
+          return false;
+        }
+      }
+      else {
+        // The closing bracket is sent as its own segment, the entries go out straight from the batch memory
+        static const uint8_t closingBracket = ']';
+        const uint8_t *segments[2U] = {reinterpret_cast<const uint8_t*>(m_batch_buffer), &closingBracket};
+        const size_t lengths[2U] = {m_batch_length, 1U};
+        if (!m_client.publish_segments(TELEMETRY_TOPIC, segments, lengths, 2U)) {
+          return false;
+        }
+      }
+      m_batch_length = 0U;
+      m_batch_count = 0U;
+      return true;
+    }
+
+    /// @brief Sets the callback that is called once a telemetry batch published with a quality of service of 1 has been acknowledged by the broker (delivered = true),
+    /// or has been given up on by the client after its retries (delivered = false), lost batches are additionally logged
+    /// @param callback Method that should be called with the message id of the batch and whether it was delivered, nullptr to remove it
+    inline void setTelemetryDeliveryCallback(IMQTT_Client::delivery_function callback) {
+      m_delivery_callback = callback;
+    }
+
+    /// @brief Returns the amount of samples currently collected in the telemetry batch, that have not been sent yet
+    /// @return Amount of samples waiting in the telemetry batch
+    inline const size_t& getTelemetryBatchCount() const {
+      return m_batch_count;
+    }
+
+    //----------------------------------------------------------------------------
+    // Gateway API
+
+    /// @brief Connects a sub-device behind this gateway, for example a slave on a field bus, ThingsBoard creates the device if it does not exist yet.
+    /// Connected sub-devices are remembered and announced again after every reconnect, connecting an already connected sub-device does nothing.
+    /// See https://thingsboard.io/docs/reference/gateway-mqtt-api/#connect-api for more information
+    /// @param device Name of the sub-device, has to stay valid until the sub-device is disconnected again
+    /// @param type Device profile the sub-device is created with, nullptr for the default profile, has to stay valid as well
+    /// @return Whether connecting the sub-device was successful or not
+    inline bool Gateway_Connect_Device(const char *device, const char *type = nullptr) {
+      if (device == nullptr) {
+        return false;
+      }
+      if (Gateway_Find_Device(device) != m_gateway_devices.size()) {
+        return true;
+      }
+      if (m_gateway_devices.size() >= GATEWAY_MAX_DEVICES) {
+        Logger::log(GATEWAY_TOO_MANY_DEVICES);
+        return false;
+      }
+      // The batch memory is allocated once with the current buffer size of the client, like the telemetry batch, unless setGatewayBatchSize() was called before
+      if (m_gateway_records == nullptr && !setGatewayBatchSize(m_client.get_buffer_size())) {
+        return false;
+      }
+
+      StaticJsonDocument<JSON_OBJECT_SIZE(0U)> nameBuffer;
+      nameBuffer.set(device);
+      Gateway_Device entry;
+      entry.name = device;
+      entry.type = type;
+      entry.name_size = measureJson(nameBuffer);
+      entry.pending = 0U;
+      m_gateway_devices.push_back(entry);
+      // Announced now if we are connected, else after the next connect
+      return !m_client.connected() || Gateway_Announce_Device(entry);
+    }
+
+    /// @brief Disconnects a sub-device, telemetry still waiting in the gateway batch is sent beforehand.
+    /// See https://thingsboard.io/docs/reference/gateway-mqtt-api/#disconnect-api for more information
+    /// @param device Name of the sub-device
+    /// @return Whether disconnecting the sub-device was successful or not
+    inline bool Gateway_Disconnect_Device(const char *device) {
+      const size_t index = Gateway_Find_Device(device);
+      if (index == m_gateway_devices.size()) {
+        return true;
+      }
+      // Entries in the batch refer to sub-devices by index, which changes once one is removed
+      if (!flushGatewayTelemetry()) {
+        return false;
+      }
+      StaticJsonDocument<JSON_OBJECT_SIZE(1U)> requestBuffer;
+      const JsonObject requestObject = requestBuffer.to<JsonObject>();
+      requestObject[GATEWAY_DEVICE_KEY] = device;
+      Helper::remove(m_gateway_devices, index);
+      return !m_client.connected() || Send_Json(GATEWAY_DISCONNECT_TOPIC, requestObject, Helper::Measure_Json(requestObject));
+    }
+
+    /// @brief Sets the size of the gateway batch memory, which is otherwise allocated with the current buffer size of the client once the first sub-device is connected.
+    /// The batch is published in segments straight from that memory, so it may be bigger than the buffer of the underlying client.
+    /// Samples still waiting in the batch are sent beforehand
+    /// @param batchSize Size of the batch memory in bytes, which is allocated once
+    /// @return Whether sending the waiting samples and allocating the batch memory was successful or not
+    inline bool setGatewayBatchSize(const size_t& batchSize) {
+      if (batchSize == 0U || !flushGatewayTelemetry()) {
+        return false;
+      }
+      if (m_gateway_records_capacity == batchSize) {
+        return true;
+      }
+      delete[] m_gateway_records;
+      m_gateway_records = new char[batchSize];
+      m_gateway_records_capacity = batchSize;
+      return true;
+    }
+
+    /// @brief Adds one timestamped sample of a connected sub-device to the gateway batch, which collects the samples of all sub-devices
+    /// in the form {"Device A":[{"ts":...,"values":{...}}, ...], "Device B":[...]} until flushGatewayTelemetry() sends them with a single publish.
+    /// The batch is flushed early only if the next sample would not fit into the gateway batch memory anymore.
+    /// See https://thingsboard.io/docs/reference/gateway-mqtt-api/#telemetry-upload-api for more information
+    /// @param device Name of the sub-device, has to be connected with Gateway_Connect_Device() first
+    /// @param data Array containing all the key value pairs of the sample
+    /// @param data_count Amount of data entries in the array that we want to send
+    /// @param timestamp Unix time in milliseconds the sample was taken at, 0 if unknown (the server time of arrival is used instead)
+    /// @return Whether adding the sample, and sending the batch if that was required, was successful or not
+    inline bool sendGatewayTelemetry(const char *device, const Telemetry *data, size_t data_count, const uint64_t& timestamp) {
+      const size_t index = Gateway_Find_Device(device);
+      if (index == m_gateway_devices.size()) {
+        char message[Helper::detectSize(GATEWAY_DEVICE_UNKNOWN, device)];
+        snprintf_P(message, sizeof(message), GATEWAY_DEVICE_UNKNOWN, device);
+        Logger::log(message);
+        return false;
+      }
+#if THINGSBOARD_ENABLE_DYNAMIC
+      // String are const char* and therefore stored as a pointer --> zero copy, meaning the size for the strings is 0 bytes,
+      // Data structure size depends on the amount of key value pairs passed + the ts and values keys of the entry.
+      // See https://arduinojson.org/v6/assistant/ for more information on the needed size for the JsonDocument
+      const size_t dataStructureMemoryUsage = JSON_OBJECT_SIZE(2U) + JSON_OBJECT_SIZE(data_count);
+      TBJsonDocument jsonBuffer(dataStructureMemoryUsage);
+#else
+      if (MaxFieldsAmt < data_count) {
+        char message[Helper::detectSize(TOO_MANY_JSON_FIELDS, data_count, MaxFieldsAmt)];
+        snprintf_P(message, sizeof(message), TOO_MANY_JSON_FIELDS, data_count, MaxFieldsAmt);
+        Logger::log(message);
+        return false;
+      }
+      StaticJsonDocument<JSON_OBJECT_SIZE(2U) + JSON_OBJECT_SIZE(MaxFieldsAmt)> jsonBuffer;
+#endif // !THINGSBOARD_ENABLE_DYNAMIC
+
+      const JsonObject entry = jsonBuffer.template to<JsonObject>();
+      if (!Serialize_Telemetry_Entry(entry, data, data_count, timestamp)) {
+        return false;
+      }
+      return Append_Gateway_Telemetry(index, entry);
+    }
+
+    /// @brief Sends the samples of all sub-devices currently collected in the gateway batch with a single publish,
+    /// in segments straight from the batch memory, so the payload is never copied into one buffer
+    /// @return Whether sending the batch was successful or not, if it was not the samples are kept and sent with the next flush
+    inline bool flushGatewayTelemetry() {
+      if (m_gateway_count == 0U) {
+        return true;
+      }
+      // Braces of the payload, separator + quoted name + colon and opening bracket + closing bracket per sub-device and one segment per entry
+      const size_t segmentCount = 2U + 4U * m_gateway_devices.size() + m_gateway_count;
+      size_t namesSize = 0U;
+      for (const Gateway_Device& device : m_gateway_devices) {
+        namesSize += device.name_size + 1U;
+      }
+      const size_t memorySize = segmentCount * (sizeof(const uint8_t *) + sizeof(size_t)) + namesSize;
+      bool result = false;
+      if (getMaximumStackSize() < memorySize) {
+        const uint8_t **segments = new const uint8_t *[segmentCount];
+        size_t *lengths = new size_t[segmentCount];
+        char *names = new char[namesSize];
+        result = Publish_Gateway_Payload(segments, lengths, names, namesSize);
+        // Ensure to actually delete the memory placed onto the heap, to make sure we do not create a memory leak
+        delete[] segments;
+        delete[] lengths;
+        delete[] names;
+      }
+      else {
+        const uint8_t *segments[segmentCount];
+        size_t lengths[segmentCount];
+        char names[namesSize];
+        result = Publish_Gateway_Payload(segments, lengths, names, namesSize);
+      }
+      if (!result) {
+        return false;
+      }
+
+      m_gateway_records_length = 0U;
+      m_gateway_count = 0U;
+      for (Gateway_Device& device : m_gateway_devices) {
+        device.pending = 0U;
+      }
+      return true;
+    }
+
+    /// @brief Returns the amount of samples currently collected in the gateway batch, that have not been sent yet
+    /// @return Amount of samples waiting in the gateway batch
+    inline const size_t& getGatewayTelemetryCount() const {
+      return m_gateway_count;
+    }
+
+    /// @brief Attempts to send client-side attributes of a connected sub-device, they are sent immediately and not batched.
+    /// See https://thingsboard.io/docs/reference/gateway-mqtt-api/#publish-attribute-update-to-the-server for more information
+    /// @param device Name of the sub-device
+    /// @param data Array containing all the attributes we want to send
+    /// @param data_count Amount of data entries in the array that we want to send
+    /// @return Whether sending the data was successful or not
+    inline bool sendGatewayAttributes(const char *device, const Attribute *data, size_t data_count) {
+      if (Gateway_Find_Device(device) == m_gateway_devices.size()) {
+        char message[Helper::detectSize(GATEWAY_DEVICE_UNKNOWN, device)];
+        snprintf_P(message, sizeof(message), GATEWAY_DEVICE_UNKNOWN, device);
+        Logger::log(message);
+        return false;
+      }
+#if THINGSBOARD_ENABLE_DYNAMIC
+      // Data structure size depends on the amount of key value pairs passed + the object of the sub-device.
+      // See https://arduinojson.org/v6/assistant/ for more information on the needed size for the JsonDocument
+      const size_t dataStructureMemoryUsage = JSON_OBJECT_SIZE(1U) + JSON_OBJECT_SIZE(data_count);
+      TBJsonDocument jsonBuffer(dataStructureMemoryUsage);
+#else
+      if (MaxFieldsAmt < data_count) {
+        char message[Helper::detectSize(TOO_MANY_JSON_FIELDS, data_count, MaxFieldsAmt)];
+        snprintf_P(message, sizeof(message), TOO_MANY_JSON_FIELDS, data_count, MaxFieldsAmt);
+        Logger::log(message);
+        return false;
+      }
+      StaticJsonDocument<JSON_OBJECT_SIZE(1U) + JSON_OBJECT_SIZE(MaxFieldsAmt)> jsonBuffer;
+#endif // !THINGSBOARD_ENABLE_DYNAMIC
+
+      const JsonObject object = jsonBuffer.template to<JsonObject>();
+      const JsonVariant values = object.createNestedObject(device);
+      for (size_t i = 0; i < data_count; i++) {
+        if (!data[i].SerializeKeyValue(values)) {
+          Logger::log(UNABLE_TO_SERIALIZE);
+          return false;
+        }
+      }
+      return Send_Json(GATEWAY_ATTRIBUTES_TOPIC, object, Helper::Measure_Json(object));
+    }
+
     //----------------------------------------------------------------------------
     // Attribute API
 
@@ -771,13 +1270,21 @@ class ThingsBoardSized {
         return false;
       }
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
-      if (!m_client.subscribe(RPC_SUBSCRIBE_TOPIC)) {
+      if (m_rpc_callbacks.size() + std::distance(first_itr, last_itr) > RPC_METHOD_TABLE_CAPACITY) {
+        Logger::log(RPC_METHOD_TABLE_FULL);
+        return false;
+      }
+      else if (!m_client.subscribe(RPC_SUBSCRIBE_TOPIC)) {
         Logger::log(SUBSCRIBE_TOPIC_FAILED);
         return false;
       }
 
       // Push back complete vector into our local m_rpc_callbacks vector.
+      const size_t first_index = m_rpc_callbacks.size();
       m_rpc_callbacks.insert(m_rpc_callbacks.end(), first_itr, last_itr);
+      for (size_t i = first_index; i < m_rpc_callbacks.size(); i++) {
+        RPC_Method_Insert(i);
+      }
       return true;
     }
 
@@ -797,13 +1304,18 @@ class ThingsBoardSized {
         return false;
       }
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
-      if (!m_client.subscribe(RPC_SUBSCRIBE_TOPIC)) {
+      if (m_rpc_callbacks.size() + callbacksSize > RPC_METHOD_TABLE_CAPACITY) {
+        Logger::log(RPC_METHOD_TABLE_FULL);
+        return false;
+      }
+      else if (!m_client.subscribe(RPC_SUBSCRIBE_TOPIC)) {
         Logger::log(SUBSCRIBE_TOPIC_FAILED);
         return false;
       }
 
       for (size_t i = 0; i < callbacksSize; i++) {
         m_rpc_callbacks.push_back(callbacks[i]);
+        RPC_Method_Insert(m_rpc_callbacks.size() - 1U);
       }
       return true;
     }
@@ -822,13 +1334,18 @@ class ThingsBoardSized {
         return false;
       }
 #endif // !THINGSBOARD_ENABLE_DYNAMIC
-      if (!m_client.subscribe(RPC_SUBSCRIBE_TOPIC)) {
+      if (m_rpc_callbacks.size() + 1U > RPC_METHOD_TABLE_CAPACITY) {
+        Logger::log(RPC_METHOD_TABLE_FULL);
+        return false;
+      }
+      else if (!m_client.subscribe(RPC_SUBSCRIBE_TOPIC)) {
         Logger::log(SUBSCRIBE_TOPIC_FAILED);
         return false;
       }
 
       // Push back given callback into our local vector
       m_rpc_callbacks.push_back(callback);
+      RPC_Method_Insert(m_rpc_callbacks.size() - 1U);
       return true;
     }
 
@@ -839,6 +1356,9 @@ class ThingsBoardSized {
     inline bool RPC_Unsubscribe() {
       // Empty all callbacks
       m_rpc_callbacks.clear();
+      for (RPC_Method_Slot& slot : m_rpc_method_table) {
+        slot = RPC_Method_Slot();
+      }
       return m_client.unsubscribe(RPC_SUBSCRIBE_TOPIC);
     }
 
@@ -902,7 +1422,12 @@ class ThingsBoardSized {
       snprintf_P(topic, sizeof(topic), RPC_SEND_REQUEST_TOPIC, m_request_id);
 
       const size_t objectSize = Helper::Measure_Json(requestBuffer);
-      return Send_Json(topic, requestBuffer, objectSize);
+      if (!Send_Json(topic, requestBuffer, objectSize)) {
+        // No response will ever arrive for a request that was not sent
+        Free_RPC_Request(m_request_id % RPC_REQUEST_SLOTS);
+        return false;
+      }
+      return true;
     }
 
     //----------------------------------------------------------------------------
@@ -1089,6 +1614,20 @@ class ThingsBoardSized {
   
   private:
 
+    /// @brief Entry of the server-side RPC method table
+    struct RPC_Method_Slot {
+      uint32_t hash; // Hash of the method name of the callback
+      size_t index; // Index of the callback in m_rpc_callbacks + 1, 0 marks a free slot
+    };
+
+    /// @brief Sub-device connected through the gateway API
+    struct Gateway_Device {
+      const char *name; // Name of the sub-device, owned by the caller
+      const char *type; // Device profile of the sub-device, nullptr for the default profile
+      size_t name_size; // Size of the serialized, quoted name
+      size_t pending; // Amount of samples of the sub-device in the gateway telemetry batch
+    };
+
 #if THINGSBOARD_ENABLE_STREAM_UTILS
 
     /// @brief Serialize the custom attribute source into the underlying client.
@@ -1406,7 +1945,7 @@ class ThingsBoardSized {
         return;
       }
 
-      m_ota.Start_Firmware_Update(m_fw_callback, fw_size, fw_algorithm, fw_checksum, fw_checksum_algorithm);
+      m_ota.Start_Firmware_Update(m_fw_callback, fw_title, fw_version, fw_size, fw_algorithm, fw_checksum, fw_checksum_algorithm);
     }
 
 #endif // THINGSBOARD_ENABLE_OTA
@@ -1427,6 +1966,10 @@ class ThingsBoardSized {
 
       // Only attempt to resubscribe if we connected successfully
       Resubscribe_Topics();
+      // The server forgets about sub-devices with the session, so they need to be announced again as well
+      for (const Gateway_Device& device : m_gateway_devices) {
+        Gateway_Announce_Device(device);
+      }
       return connection_result;
     }
 
@@ -1451,7 +1994,6 @@ class ThingsBoardSized {
     /// the internal memory blocks might need to be moved to a new location
     inline void reserve_callback_size(const size_t& reservedSize) {
       m_rpc_callbacks.reserve(reservedSize);
-      m_rpc_request_callbacks.reserve(reservedSize);
       m_shared_attribute_update_callbacks.reserve(reservedSize);
       m_attribute_request_callbacks.reserve(reservedSize);
     }
@@ -1462,29 +2004,78 @@ class ThingsBoardSized {
     /// @param registeredCallback Editable pointer to a reference of the local version that was copied from the passed callback
     /// @return Whether requesting the given callback was successful or not
     inline bool RPC_Request_Subscribe(const RPC_Request_Callback& callback, RPC_Request_Callback*& registeredCallback = nullptr) {
-#if !THINGSBOARD_ENABLE_DYNAMIC
-      if (m_rpc_request_callbacks.size() + 1 > m_rpc_request_callbacks.capacity()) {
-        Logger::log(MAX_RPC_REQUEST_EXCEEDED);
-        return false;
+      // If every slot is still taken by a request without a response, even after the expired ones were dropped,
+      // the oldest request is dropped as well, because a lost response would otherwise block its slot forever
+      Expire_RPC_Requests();
+      if (m_rpc_request_count == RPC_REQUEST_SLOTS) {
+        Logger::log(RPC_REQUEST_SLOTS_FULL);
+        size_t oldest = 0U;
+        for (size_t i = 1U; i < RPC_REQUEST_SLOTS; i++) {
+          if (m_rpc_request_taken[i] < m_rpc_request_taken[oldest]) {
+            oldest = i;
+          }
+        }
+        Free_RPC_Request(oldest);
       }
-#endif // !THINGSBOARD_ENABLE_DYNAMIC
+
+      // The request is stored in the slot of the id it will be sent with, which is the next one.
+      // Ids whose slot is still taken by an older request, that did not receive a response yet, are skipped
+      for (size_t i = 0U; i < RPC_REQUEST_SLOTS && m_rpc_request_slots[(m_request_id + 1U) % RPC_REQUEST_SLOTS].Get_Request_ID() != 0U; i++) {
+        m_request_id++;
+      }
+      const size_t index = (m_request_id + 1U) % RPC_REQUEST_SLOTS;
       if (!m_client.subscribe(RPC_RESPONSE_SUBSCRIBE_TOPIC)) {
         Logger::log(SUBSCRIBE_TOPIC_FAILED);
         return false;
       }
 
-      // Push back given callback into our local vector
-      m_rpc_request_callbacks.push_back(callback);
-      registeredCallback = &m_rpc_request_callbacks.back();
+      // Copy given callback into its slot, the request id is set once the request is sent
+      RPC_Request_Callback& slot = m_rpc_request_slots[index];
+      slot = callback;
+      m_rpc_request_taken[index] = Get_Time_Ms();
+      m_rpc_request_count++;
+      registeredCallback = &slot;
       return true;
     }
 
+    /// @brief Frees the slot of a pending client-side RPC request and unsubscribes from the response topic,
+    /// if we are not waiting for any further responses. Will be resubscribed if another request is sent anyway
+    /// @param index Index of the slot that should be freed
+    inline void Free_RPC_Request(const size_t& index) {
+      m_rpc_request_slots[index] = RPC_Request_Callback();
+      m_rpc_request_count--;
+      if (m_rpc_request_count == 0U) {
+        RPC_Request_Unsubscribe();
+      }
+    }
+
+    /// @brief Frees the slots of all pending client-side RPC requests that did not receive a response within RPC_REQUEST_TIMEOUT_MS
+    inline void Expire_RPC_Requests() {
+      if (m_rpc_request_count == 0U) {
+        return;
+      }
+      const uint64_t now = Get_Time_Ms();
+      for (size_t i = 0U; i < RPC_REQUEST_SLOTS; i++) {
+        const size_t& request_id = m_rpc_request_slots[i].Get_Request_ID();
+        if (request_id == 0U || now - m_rpc_request_taken[i] < RPC_REQUEST_TIMEOUT_MS) {
+          continue;
+        }
+        char message[Helper::detectSize(RPC_REQUEST_EXPIRED, request_id)];
+        snprintf_P(message, sizeof(message), RPC_REQUEST_EXPIRED, request_id);
+        Logger::log(message);
+        Free_RPC_Request(i);
+      }
+    }
+
     /// @brief Unsubscribes all client-side RPC request callbacks
     /// @return Whether unsubcribing the previously subscribed callbacks
     /// and from the client-side RPC response topic, was successful or not
     inline bool RPC_Request_Unsubscribe() {
       // Empty all callbacks
-      m_rpc_request_callbacks.clear();
+      for (RPC_Request_Callback& slot : m_rpc_request_slots) {
+        slot = RPC_Request_Callback();
+      }
+      m_rpc_request_count = 0U;
       return m_client.unsubscribe(RPC_RESPONSE_SUBSCRIBE_TOPIC);
     }
 
@@ -1544,33 +2135,69 @@ class ThingsBoardSized {
       return telemetry ? sendTelemetryJson(object, Helper::Measure_Json(object)) : sendAttributeJSON(object, Helper::Measure_Json(object));
     }
 
+    /// @brief Inserts the server-side RPC callback at the given index of m_rpc_callbacks into the method table,
+    /// if a callback with the same method name was subscribed before, that one keeps being called
+    /// @param index Index of the callback in m_rpc_callbacks
+    inline void RPC_Method_Insert(const size_t& index) {
+      const char *methodName = m_rpc_callbacks.at(index).Get_Name();
+      if (methodName == nullptr) {
+        Logger::log(RPC_METHOD_NULL);
+        return;
+      }
+      const uint32_t hash = Helper::hashString(methodName);
+      // Linear probing, the table is never more than three quarters full so there always is a free slot
+      for (size_t i = hash & (RPC_METHOD_TABLE_SIZE - 1U); ; i = (i + 1U) & (RPC_METHOD_TABLE_SIZE - 1U)) {
+        RPC_Method_Slot& slot = m_rpc_method_table[i];
+        if (slot.index == 0U) {
+          slot.hash = hash;
+          slot.index = index + 1U;
+          return;
+        }
+        else if (slot.hash == hash && strcmp(m_rpc_callbacks.at(slot.index - 1U).Get_Name(), methodName) == 0) {
+          return;
+        }
+      }
+    }
+
+    /// @brief Looks up the server-side RPC callback subscribed for the given method name
+    /// @param methodName Name of the method received from the server
+    /// @return Subscribed callback or nullptr if there is none for the given method name
+    inline const RPC_Callback* RPC_Method_Find(const char *methodName) const {
+      const uint32_t hash = Helper::hashString(methodName);
+      for (size_t i = hash & (RPC_METHOD_TABLE_SIZE - 1U); ; i = (i + 1U) & (RPC_METHOD_TABLE_SIZE - 1U)) {
+        const RPC_Method_Slot& slot = m_rpc_method_table[i];
+        if (slot.index == 0U) {
+          return nullptr;
+        }
+        const RPC_Callback& rpc = m_rpc_callbacks.at(slot.index - 1U);
+        if (slot.hash == hash && strcmp(rpc.Get_Name(), methodName) == 0) {
+          return &rpc;
+        }
+      }
+    }
+
+    /// @brief Parses the request or response id that follows the given topic prefix and the "/" seperating it from the id,
+    /// directly from the received topic without copying it
+    /// @param topic Topic we received the message over
+    /// @param prefixLength Length of the topic prefix before the id
+    /// @return Parsed id or 0 if the topic does not contain one
+    inline static size_t Parse_Topic_ID(const char *topic, const size_t& prefixLength) {
+      if (topic[prefixLength] != '/') {
+        return 0U;
+      }
+      return strtoul(topic + prefixLength + 1U, nullptr, 10);
+    }
+
     /// @brief Process callback that will be called upon client-side RPC response arrival
     /// and is responsible for handling the payload and calling the appropriate previously subscribed callbacks
     /// @param topic Previously subscribed topic, we got the response over
     /// @param data Payload sent by the server over our given topic, that contains our key value pairs
     inline void process_rpc_request_message(char *topic, const JsonObjectConst& data) {
-      // Remove the not needed part of the received topic string, which is everything before the response id,
-      // therefore we remove the section before that which is the topic + an additional "/" character, that seperates the topic from the response id.
-      // Meaning the index we want to get the substring from is the length of the topic + 1 for the additonal "/" character
-      const size_t index = strlen(RPC_RESPONSE_TOPIC) + 1U;
-#if THINGSBOARD_ENABLE_STL
-      std::string response = topic;
-      response = response.substr(index, response.length() - index);
-#else
-      String response = topic;
-      response = response.substring(index);
-#endif // THINGSBOARD_ENABLE_STL
-
-      // Convert the remaining text after the topic to an integer, because it should now contain only the response id
-      const size_t response_id = atoi(response.c_str());
-
-      for (size_t i = 0; i < m_rpc_request_callbacks.size(); i++) {
-        const RPC_Request_Callback& rpc_request = m_rpc_request_callbacks.at(i);
-
-        if (rpc_request.Get_Request_ID() != response_id) {
-          continue;
-        }
+      const size_t response_id = Parse_Topic_ID(topic, strlen(RPC_RESPONSE_TOPIC));
+      const size_t index = response_id % RPC_REQUEST_SLOTS;
+      RPC_Request_Callback& rpc_request = m_rpc_request_slots[index];
 
+      if (response_id != 0U && rpc_request.Get_Request_ID() == response_id) {
 #if THINGSBOARD_ENABLE_DEBUG
         char message[Helper::detectSize(CALLING_REQUEST_CB, response_id)];
         snprintf_P(message, sizeof(message), CALLING_REQUEST_CB, response_id);
@@ -1581,16 +2208,8 @@ class ThingsBoardSized {
         // set JSONVariant to null
         rpc_request.Call_Callback<Logger>(data);
 
-        // Delete callback because the changes have been requested and the callback is no longer needed
-        Helper::remove(m_rpc_request_callbacks, i);
-        break;
-      }
-
-      // Attempt to unsubscribe from the shared attribute request topic,
-      // if we are not waiting for any further responses with shared attributes from the server.
-      // Will be resubscribed if another request is sent anyway
-      if (m_rpc_request_callbacks.empty()) {
-        RPC_Request_Unsubscribe();
+        // Free the slot because the changes have been requested and the callback is no longer needed
+        Free_RPC_Request(index);
       }
     }
 
@@ -1606,58 +2225,34 @@ class ThingsBoardSized {
         return;
       }
  
-      RPC_Response response;
-
-      for (const RPC_Callback& rpc : m_rpc_callbacks) {
-        const char *subscribedMethodName = rpc.Get_Name();
-        if (subscribedMethodName == nullptr) {
-          Logger::log(RPC_METHOD_NULL);
-          continue;
-        }
-        // Strncmp returns the ascii value difference of the ascii characters that are different,
-        // meaning 0 is the same string and less and more than 0 is the difference in ascci values between the 2 chararacters.
-        else if (strncmp(subscribedMethodName, methodName, strlen(subscribedMethodName)) != 0) {
-          continue;
-        }
+      const RPC_Callback *rpc = RPC_Method_Find(methodName);
+      if (rpc == nullptr) {
+        // Message is ignored and not sent at all.
+        return;
+      }
 
-        // Do not inform client, if parameter field is missing for some reason
-        if (!data.containsKey(RPC_PARAMS_KEY)) {
+      // Do not inform client, if parameter field is missing for some reason
+      if (!data.containsKey(RPC_PARAMS_KEY)) {
 #if THINGSBOARD_ENABLE_DEBUG
-          Logger::log(NO_RPC_PARAMS_PASSED);
+        Logger::log(NO_RPC_PARAMS_PASSED);
 #endif // THINGSBOARD_ENABLE_DEBUG
-        }
+      }
 
 #if THINGSBOARD_ENABLE_DEBUG
-        char message[JSON_STRING_SIZE(strlen(CALLING_RPC_CB)) + JSON_STRING_SIZE(strlen(methodName))];
-        snprintf_P(message, sizeof(message), CALLING_RPC_CB, methodName);
-        Logger::log(message);
+      char message[JSON_STRING_SIZE(strlen(CALLING_RPC_CB)) + JSON_STRING_SIZE(strlen(methodName))];
+      snprintf_P(message, sizeof(message), CALLING_RPC_CB, methodName);
+      Logger::log(message);
 #endif // THINGSBOARD_ENABLE_DEBUG
 
-        const JsonVariantConst param = data[RPC_PARAMS_KEY].as<JsonVariantConst>();
-        response = rpc.Call_Callback<Logger>(param);
-        break;
-      }
+      const JsonVariantConst param = data[RPC_PARAMS_KEY].as<JsonVariantConst>();
+      const RPC_Response response = rpc->Call_Callback<Logger>(param);
 
       if (response.isNull()) {
         // Message is ignored and not sent at all.
         return;
       }
 
-      // Remove the not needed part of the received topic string, which is everything before the request id,
-      // therefore we remove the section before that which is the topic + an additional "/" character, that seperates the topic from the request id.
-      // Meaning the index we want to get the substring from is the length of the topic + 1 for the additonal "/" character
-      const size_t index = strlen(RPC_REQUEST_TOPIC) + 1U;
-#if THINGSBOARD_ENABLE_STL
-      std::string request = topic;
-      request = request.substr(index, request.length() - index);
-#else
-      String request = topic;
-      request = request.substring(index);
-#endif // THINGSBOARD_ENABLE_STL
-
-      // Convert the remaining text after the topic to an integer, because it should now contain only the request id
-      const size_t request_id = atoi(request.c_str());
-
+      const size_t request_id = Parse_Topic_ID(topic, strlen(RPC_REQUEST_TOPIC));
       char responseTopic[Helper::detectSize(RPC_SEND_RESPONSE_TOPIC, request_id)];
       snprintf_P(responseTopic, sizeof(responseTopic), RPC_SEND_RESPONSE_TOPIC, request_id);
 
@@ -1910,6 +2505,208 @@ class ThingsBoardSized {
       return telemetry ? sendTelemetryJson(object, Helper::Measure_Json(object)) : sendAttributeJSON(object, Helper::Measure_Json(object));
     }
 
+    /// @brief Serializes the given entry directly into the telemetry batch, flushing the batch beforehand if the entry would not fit anymore
+    /// and afterwards if the configured maximum amount of samples has been reached
+    /// @param entry Entry containing the timestamp and the key value pairs of one sample
+    /// @return Whether appending the entry, and sending the batch if that was required, was successful or not
+    inline bool Append_Telemetry_Batch(const JsonVariant& entry) {
+      // Size of the entry including the null end terminator, which is replaced by the separator or the closing bracket
+      // The closing bracket is not stored, flushTelemetryBatch() sends it as a separate segment
+      const size_t entrySize = Helper::Measure_Json(entry);
+      const size_t capacity = m_batch_capacity;
+
+      // The entry alone does not fit into an array, send it on its own, a single timestamped object is accepted by ThingsBoard as well
+      if (entrySize + 1U > capacity) {
+        return flushTelemetryBatch() && sendTelemetryJson(entry, entrySize);
+      }
+      // Opening bracket or separator + entry + null end terminator
+      if (m_batch_length + entrySize + 1U > capacity && !flushTelemetryBatch()) {
+        return false;
+      }
+
+      m_batch_buffer[m_batch_length] = (m_batch_count == 0U) ? '[' : COMMA;
+      const size_t written = serializeJson(entry, m_batch_buffer + m_batch_length + 1U, capacity - m_batch_length - 1U);
+      if (written < entrySize - 1U) {
+        Logger::log(UNABLE_TO_SERIALIZE_JSON);
+        return false;
+      }
+      m_batch_length += written + 1U;
+
+      if (m_batch_count == 0U) {
+        m_batch_started = Get_Time_Ms();
+      }
+      m_batch_count++;
+
+      if (m_batch_max_samples != 0U && m_batch_count >= m_batch_max_samples) {
+        return flushTelemetryBatch();
+      }
+      return true;
+    }
+
+    /// @brief Serializes one timestamped sample into the given entry, {"ts":...,"values":{...}} or only the values object if the timestamp is unknown
+    /// @param entry Object the sample is serialized into
+    /// @param data Array containing all the key value pairs of the sample
+    /// @param data_count Amount of data entries in the array
+    /// @param timestamp Unix time in milliseconds the sample was taken at, 0 if unknown
+    /// @return Whether serializing all key value pairs was successful or not
+    inline bool Serialize_Telemetry_Entry(const JsonObject& entry, const Telemetry *data, size_t data_count, const uint64_t& timestamp) {
+      // Without a timestamp the plain values object is sent, which ThingsBoard accepts as an array element as well
+      JsonVariant values = entry;
+      if (timestamp != 0U) {
+        entry[TS_KEY] = timestamp;
+        values = entry.createNestedObject(VALUES_KEY);
+      }
+
+      for (size_t i = 0; i < data_count; i++) {
+        if (!data[i].SerializeKeyValue(values)) {
+          Logger::log(UNABLE_TO_SERIALIZE);
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /// @brief Returns the index of the connected sub-device with the given name
+    /// @param device Name of the sub-device
+    /// @return Index into the connected sub-devices, or their amount if there is none with the given name
+    inline size_t Gateway_Find_Device(const char *device) const {
+      const size_t count = m_gateway_devices.size();
+      if (device == nullptr) {
+        return count;
+      }
+      for (size_t i = 0; i < count; i++) {
+        if (strcmp(m_gateway_devices.cbegin()[i].name, device) == 0) {
+          return i;
+        }
+      }
+      return count;
+    }
+
+    /// @brief Publishes the connect message of the given sub-device
+    /// @param device Sub-device that should be announced to the server
+    /// @return Whether sending the connect message was successful or not
+    inline bool Gateway_Announce_Device(const Gateway_Device& device) {
+      StaticJsonDocument<JSON_OBJECT_SIZE(2U)> requestBuffer;
+      const JsonObject requestObject = requestBuffer.to<JsonObject>();
+      requestObject[GATEWAY_DEVICE_KEY] = device.name;
+      if (device.type != nullptr) {
+        requestObject[GATEWAY_TYPE_KEY] = device.type;
+      }
+      return Send_Json(GATEWAY_CONNECT_TOPIC, requestObject, Helper::Measure_Json(requestObject));
+    }
+
+    /// @brief Serializes the given entry into the gateway batch, flushing the batch beforehand if the entry would not fit anymore.
+    /// Entries are kept in order of arrival, each prefixed with the index of its sub-device and the separator to the previous entry and null terminated,
+    /// they are grouped per sub-device only when the payload is published
+    /// @param index Index of the sub-device the entry belongs to
+    /// @param entry Entry containing the timestamp and the key value pairs of one sample
+    /// @return Whether appending the entry, and sending the batch if that was required, was successful or not
+    inline bool Append_Gateway_Telemetry(const size_t& index, const JsonVariant& entry) {
+      Gateway_Device& device = m_gateway_devices[index];
+      // Size of the entry including the null end terminator
+      const size_t entrySize = Helper::Measure_Json(entry);
+      // Index byte + separator + entry + null end terminator
+      const size_t recordSize = entrySize + 2U;
+
+      if (m_gateway_records_length + recordSize > m_gateway_records_capacity) {
+        if (!flushGatewayTelemetry()) {
+          return false;
+        }
+        if (recordSize > m_gateway_records_capacity) {
+          char message[Helper::detectSize(INVALID_BUFFER_SIZE, m_gateway_records_capacity, recordSize)];
+          snprintf_P(message, sizeof(message), INVALID_BUFFER_SIZE, m_gateway_records_capacity, recordSize);
+          Logger::log(message);
+          return false;
+        }
+      }
+
+      char *record = m_gateway_records + m_gateway_records_length;
+      record[0] = static_cast<char>(index);
+      record[1] = COMMA;
+      const size_t written = serializeJson(entry, record + 2U, entrySize);
+      if (written < entrySize - 1U) {
+        Logger::log(UNABLE_TO_SERIALIZE_JSON);
+        return false;
+      }
+      m_gateway_records_length += recordSize;
+      device.pending++;
+      m_gateway_count++;
+      return true;
+    }
+
+    /// @brief Publishes the gateway telemetry payload as segments, grouping the collected entries per sub-device.
+    /// The entries are sent straight from the batch memory, only the quoted sub-device names are written into the given memory
+    /// @param segments Memory for the segment pointers, has to hold at least 2 + 4 * sub-devices + entries
+    /// @param lengths Memory for the segment lengths, same size as segments
+    /// @param names Memory the quoted sub-device names are serialized into
+    /// @param namesSize Size of the names memory, has to be at least the quoted size + 1 of every sub-device name
+    /// @return Whether publishing the payload was successful or not
+    inline bool Publish_Gateway_Payload(const uint8_t **segments, size_t *lengths, char *names, const size_t& namesSize) {
+      static const uint8_t openBrace = '{';
+      static const uint8_t closeBrace = '}';
+      static const uint8_t comma = COMMA;
+      static const uint8_t openArray[2U] = {':', '['};
+      static const uint8_t closeArray = ']';
+
+      size_t count = 0U;
+      char *name = names;
+      segments[count] = &openBrace;
+      lengths[count++] = 1U;
+      bool firstDevice = true;
+      const size_t deviceCount = m_gateway_devices.size();
+      for (size_t i = 0; i < deviceCount; i++) {
+        const Gateway_Device& device = m_gateway_devices.cbegin()[i];
+        if (device.pending == 0U) {
+          continue;
+        }
+        if (!firstDevice) {
+          segments[count] = &comma;
+          lengths[count++] = 1U;
+        }
+        firstDevice = false;
+
+        StaticJsonDocument<JSON_OBJECT_SIZE(0U)> nameBuffer;
+        nameBuffer.set(device.name);
+        const size_t nameLength = serializeJson(nameBuffer, name, names + namesSize - name);
+        segments[count] = reinterpret_cast<const uint8_t *>(name);
+        lengths[count++] = nameLength;
+        name += nameLength + 1U;
+        segments[count] = openArray;
+        lengths[count++] = sizeof(openArray);
+
+        bool firstEntry = true;
+        const char *record = m_gateway_records;
+        const char *recordsEnd = m_gateway_records + m_gateway_records_length;
+        while (record < recordsEnd) {
+          const char *json = record + 2U;
+          const size_t length = strlen(json);
+          if (static_cast<uint8_t>(record[0]) == i) {
+            // The first entry of the sub-device is sent without the separator in front of it
+            const char *start = firstEntry ? json : record + 1U;
+            segments[count] = reinterpret_cast<const uint8_t *>(start);
+            lengths[count++] = json + length - start;
+            firstEntry = false;
+          }
+          record = json + length + 1U;
+        }
+        segments[count] = &closeArray;
+        lengths[count++] = 1U;
+      }
+      segments[count] = &closeBrace;
+      lengths[count++] = 1U;
+      return m_client.publish_segments(GATEWAY_TELEMETRY_TOPIC, segments, lengths, count);
+    }
+
+    /// @brief Returns a monotonic time in milliseconds, used to determine the age of the telemetry batch
+    /// @return Milliseconds since the device started
+    inline static uint64_t Get_Time_Ms() {
+#if THINGSBOARD_USE_ESP_TIMER
+      return esp_timer_get_time() / 1000U;
+#else
+      return millis();
+#endif // THINGSBOARD_USE_ESP_TIMER
+    }
+
     /// @brief Vector signature
 #if THINGSBOARD_ENABLE_STL
     template<typename T>
@@ -1920,6 +2717,22 @@ class ThingsBoardSized {
     size_t m_max_stack; // Maximum stack size we allocate at once.
     size_t m_buffering_size; // Buffering size used to serialize directly into client.
 
+    char *m_batch_buffer; // Serialized telemetry batch, allocated once batching is enabled
+    size_t m_batch_capacity; // Allocated size of the telemetry batch
+    size_t m_batch_length; // Amount of characters currently used in the telemetry batch, excluding the closing bracket
+    size_t m_batch_count; // Amount of samples currently in the telemetry batch
+    size_t m_batch_max_samples; // Amount of samples after which the telemetry batch is flushed
+    uint64_t m_batch_max_age; // Time in milliseconds after which the telemetry batch is flushed
+    uint64_t m_batch_started; // Time in milliseconds the first sample in the current telemetry batch was added
+    uint8_t m_batch_qos; // Quality of service the telemetry batch is published with
+    IMQTT_Client::delivery_function m_delivery_callback; // Called once a telemetry batch published with a quality of service of 1 was acknowledged or lost
+
+    Vector<Gateway_Device> m_gateway_devices; // Sub-devices connected through the gateway API
+    char *m_gateway_records; // Serialized gateway telemetry entries, allocated once the first sub-device is connected
+    size_t m_gateway_records_capacity; // Allocated size of the gateway telemetry entries
+    size_t m_gateway_records_length; // Amount of bytes currently used by the gateway telemetry entries
+    size_t m_gateway_count; // Amount of samples currently in the gateway telemetry batch
+
     // Vectors hold copy of the actual passed data, this is to ensure they stay valid,
     // even if the user only temporarily created the object before the method was called.
     // This can be done because all Callback methods mostly consists of pointers to actual object so copying them
@@ -1929,12 +2742,22 @@ class ThingsBoardSized {
     // Therefore copy-by-value has been choosen as for this specific use case it is more advantageous,
     // especially because at most we copy a vector, that will only ever contain a few pointers
     Vector<RPC_Callback> m_rpc_callbacks; // Server side RPC callbacks vector, replacement for non C++ STL boards
-    Vector<RPC_Request_Callback> m_rpc_request_callbacks; // Client side RPC callbacks vector, replacement for non C++ STL boards
+    RPC_Method_Slot m_rpc_method_table[RPC_METHOD_TABLE_SIZE]; // Open addressing table of the server side RPC callbacks, keyed by the hash of their method name
+    RPC_Request_Callback m_rpc_request_slots[RPC_REQUEST_SLOTS]; // Pending client side RPC callbacks, indexed by request id
+    uint64_t m_rpc_request_taken[RPC_REQUEST_SLOTS]; // Time in milliseconds each pending client side RPC request was taken at
+    size_t m_rpc_request_count; // Amount of client side RPC requests still waiting for their response
     Vector<Shared_Attribute_Callback> m_shared_attribute_update_callbacks; // Shared attribute update callbacks vector, replacement for non C++ STL boards
     Vector<Attribute_Request_Callback> m_attribute_request_callbacks; // Client-side or shared attribute request callback vector, replacement for non C++ STL boards
 
     Provision_Callback m_provision_callback; // Provision response callback
     size_t m_request_id; // Allows nearly 4.3 million requests before wrapping back to 0
+    bool m_receiving; // Whether a received message is being processed, its payload and the strings parsed from it then still live in the client buffer
+
+#if THINGSBOARD_ENABLE_DYNAMIC
+    TBJsonDocument m_inbound_json; // Reused for every received json message, grows to the largest message received so far
+#else
+    StaticJsonDocument<JSON_OBJECT_SIZE(MaxFieldsAmt)> m_inbound_json; // Reused for every received json message
+#endif // THINGSBOARD_ENABLE_DYNAMIC
 
 #if THINGSBOARD_ENABLE_OTA
     const OTA_Update_Callback *m_fw_callback; // Ota update response callback
@@ -1943,40 +2766,67 @@ class ThingsBoardSized {
     OTA_Handler<Logger> m_ota; // Class instance that handles the flashing and creating a hash from the given received binary firmware data
 #endif // THINGSBOARD_ENABLE_OTA
 
+    /// @brief MQTT callback that will be called once a message published with a quality of service of 1 has been acknowledged or given up on,
+    /// only telemetry batches are published that way
+    /// @param message_id Id the client assigned to the message when it was published
+    /// @param delivered Whether the broker acknowledged the message or the client gave up on it
+    inline void onMQTTDelivery(uint16_t message_id, bool delivered) {
+      if (!delivered) {
+        char message[Helper::detectSize(TELEMETRY_NOT_DELIVERED, message_id)];
+        snprintf_P(message, sizeof(message), TELEMETRY_NOT_DELIVERED, message_id);
+        Logger::log(message);
+      }
+      if (m_delivery_callback != nullptr) {
+        m_delivery_callback(message_id, delivered);
+      }
+    }
+
     /// @brief MQTT callback that will be called if a publish message is received from the server
     /// @param topic Previously subscribed topic, we got the response over 
     /// @param payload Payload that was sent over the cloud and received over the given topic
     /// @param length Total length of the received payload
     inline void onMQTTMessage(char *topic, uint8_t *payload, unsigned int length) {
+      m_receiving = true;
+      process_mqtt_message(topic, payload, length);
+      m_receiving = false;
+    }
+
+    /// @brief Routes the received message to the matching subscription, responses sent while doing that are serialized into a copy
+    /// instead of the client buffer, which still contains the received payload
+    /// @param topic Previously subscribed topic, we got the response over
+    /// @param payload Payload that was sent over the cloud and received over the given topic
+    /// @param length Total length of the received payload
+    inline void process_mqtt_message(char *topic, uint8_t *payload, unsigned int length) {
 #if THINGSBOARD_ENABLE_DEBUG
       char message[JSON_STRING_SIZE(strlen(RECEIVE_MESSAGE)) + JSON_STRING_SIZE(strlen(topic))];
       snprintf_P(message, sizeof(message), RECEIVE_MESSAGE, topic);
       Logger::log(message);
 #endif // THINGSBOARD_ENABLE_DEBUG
 
+      const Topic_Route_Entry *entry = Route_Topic(topic);
+      if (entry == nullptr || !Has_Route_Listener(entry->route)) {
+        return;
+      }
+
 #if THINGSBOARD_ENABLE_OTA
       // When receiving the ota binary payload we do not want to deserialize it into json, because it only contains
       // firmware bytes that should be directly writtin into flash, therefore we can skip that step and directly process those bytes
-      if (strncmp_P(FIRMWARE_RESPONSE_TOPIC, topic, strlen(FIRMWARE_RESPONSE_TOPIC)) == 0) {
+      if (!entry->json) {
         process_firmware_response(topic, payload, length);
         return;
       }
 #endif // THINGSBOARD_ENABLE_OTA
 
+      // The document of the previous message is reused, clear() only resets its memory pool and does not release it
+      m_inbound_json.clear();
 #if THINGSBOARD_ENABLE_DYNAMIC
-      // Buffer that we deserialize is writeable and not read only --> zero copy, meaning the size for the data is 0 bytes,
-      // Data structure size depends on the amount of key value pairs received.
-      // See https://arduinojson.org/v6/assistant/ for more information on the needed size for the JsonDocument
-      const size_t dataStructureMemoryUsage = JSON_OBJECT_SIZE(Helper::getOccurences(reinterpret_cast<char*>(payload), COLON));
-      TBJsonDocument jsonBuffer(dataStructureMemoryUsage);
+      const DeserializationError error = Deserialize_Inbound_Json(payload, length);
 #else
-      StaticJsonDocument<JSON_OBJECT_SIZE(MaxFieldsAmt)> jsonBuffer;
-#endif // !THINGSBOARD_ENABLE_DYNAMIC
-
       // The deserializeJson method we use, can use the zero copy mode because a writeable input was passed,
       // if that were not the case the needed allocated memory would drastically increase, because the keys would need to be copied as well.
       // See https://arduinojson.org/v6/doc/deserialization/ for more info on ArduinoJson deserialization
-      const DeserializationError error = deserializeJson(jsonBuffer, payload, length);
+      const DeserializationError error = deserializeJson(m_inbound_json, payload, length);
+#endif // THINGSBOARD_ENABLE_DYNAMIC
       if (error) {
         char message[Helper::detectSize(UNABLE_TO_DE_SERIALIZE_JSON, error.c_str())];
         snprintf_P(message, sizeof(message), UNABLE_TO_DE_SERIALIZE_JSON, error.c_str());
@@ -1986,28 +2836,116 @@ class ThingsBoardSized {
       // .as() is used instead of .to(), because it is meant to cast the JsonDocument to the given type,
       // but it does not change the actual content of the JsonDocument, we don't want that because it already contents content
       // and would result in the data simply being "null", instead .as() allows accessing the data over a JsonObjectConst instead.
-      JsonObjectConst data = jsonBuffer.template as<JsonObjectConst>();
-
-      // Checks to ensure we forward the already json serialized data to the correct process function,
-      // especially important is the order of ATTRIBUTE_RESPONSE_TOPIC and ATTRIBUTE_TOPIC,
-      // that is the case because the more specific one that is longer but contains the same text has to be checked first,
-      // because if we do not do that then even if we receive a message from the ATTRIBUTE_RESPONSE_TOPIC
-      // we would call the process method for the ATTRIBUTE_TOPIC because we only compare until the end of the ATTRIBUTE_TOPIC string,
-      // therefore the received topic is exactly the same. Therefore the ordering needs to stay the same for thoose two specific checks
-      if (strncmp_P(RPC_RESPONSE_TOPIC, topic, strlen(RPC_RESPONSE_TOPIC)) == 0) {
-        process_rpc_request_message(topic, data);
-      }
-      else if (strncmp_P(RPC_REQUEST_TOPIC, topic, strlen(RPC_REQUEST_TOPIC)) == 0) {
-        process_rpc_message(topic, data);
+      JsonObjectConst data = m_inbound_json.template as<JsonObjectConst>();
+
+      switch (entry->route) {
+        case Topic_Route::RPC_RESPONSE:
+          process_rpc_request_message(topic, data);
+          break;
+        case Topic_Route::RPC_REQUEST:
+          process_rpc_message(topic, data);
+          break;
+        case Topic_Route::ATTRIBUTE_RESPONSE:
+          process_attribute_request_message(topic, data);
+          break;
+        case Topic_Route::ATTRIBUTE:
+          process_shared_attribute_update_message(topic, data);
+          break;
+        case Topic_Route::PROVISION_RESPONSE:
+          process_provisioning_response(topic, data);
+          break;
+        default:
+          break;
       }
-      else if (strncmp_P(ATTRIBUTE_RESPONSE_TOPIC, topic, strlen(ATTRIBUTE_RESPONSE_TOPIC)) == 0) {
-        process_attribute_request_message(topic, data);
+    }
+
+#if THINGSBOARD_ENABLE_DYNAMIC
+
+    /// @brief Deserializes the received payload into the reused JsonDocument and grows the document if the payload did not fit.
+    /// The payload is passed as read only, which copies its strings into the document. Zero copy mode would modify the payload in place,
+    /// so a message that ran out of memory could not be parsed a second time
+    /// @param payload Payload that was sent over the cloud and received over the given topic
+    /// @param length Total length of the received payload
+    /// @return Result of the last deserialization attempt
+    inline DeserializationError Deserialize_Inbound_Json(const uint8_t *payload, const size_t& length) {
+      // Every value takes at least one character of the payload and every copied string at most its own length,
+      // so a document of that size always fits and bounds the growth even for malformed input
+      const size_t maximum_size = JSON_ARRAY_SIZE(length) + length;
+      DeserializationError error = deserializeJson(m_inbound_json, payload, length);
+
+      while (error == DeserializationError::NoMemory && m_inbound_json.capacity() != 0U && m_inbound_json.capacity() < maximum_size) {
+        const size_t doubled_size = m_inbound_json.capacity() * 2U;
+        const size_t size = (doubled_size < maximum_size) ? doubled_size : maximum_size;
+        m_inbound_json = TBJsonDocument(size);
+        if (m_inbound_json.capacity() == 0U) {
+          // Allocation failed, retry with the initial size on the next message instead of staying without any memory
+          m_inbound_json = TBJsonDocument(INBOUND_JSON_INITIAL_SIZE);
+          break;
+        }
+        char message[Helper::detectSize(INBOUND_JSON_GROWN, size)];
+        snprintf_P(message, sizeof(message), INBOUND_JSON_GROWN, size);
+        Logger::log(message);
+        error = deserializeJson(m_inbound_json, payload, length);
       }
-      else if (strncmp_P(ATTRIBUTE_TOPIC, topic, strlen(ATTRIBUTE_TOPIC)) == 0) {
-        process_shared_attribute_update_message(topic, data);
+      return error;
+    }
+
+#endif // THINGSBOARD_ENABLE_DYNAMIC
+
+    /// @brief Selects the route of the given topic in a single pass over it, by comparing it against all known topic prefixes at once.
+    /// The longest prefix that matches up to a topic level wins, therefore the order of TOPIC_ROUTES does not matter,
+    /// even though for example the attribute topic is a prefix of the attribute response topic
+    /// @param topic Topic the message was received over
+    /// @return Route entry of the topic or nullptr if it is not one we subscribed to
+    inline const Topic_Route_Entry* Route_Topic(const char *topic) const {
+      uint8_t candidates = static_cast<uint8_t>((1U << TOPIC_ROUTES_AMOUNT) - 1U);
+      const Topic_Route_Entry *match = nullptr;
+
+      for (size_t i = 0U; candidates != 0U; i++) {
+        const char current = topic[i];
+        for (size_t j = 0U; j < TOPIC_ROUTES_AMOUNT; j++) {
+          const uint8_t bit = static_cast<uint8_t>(1U << j);
+          if ((candidates & bit) == 0U) {
+            continue;
+          }
+          const Topic_Route_Entry& entry = TOPIC_ROUTES[j];
+          if (i == entry.length) {
+            // Later matches are longer and therefore more specific, overwrite the previous one
+            if (current == '\0' || current == '/') {
+              match = &entry;
+            }
+            candidates &= ~bit;
+          }
+          else if (current != static_cast<char>(pgm_read_byte(entry.prefix + i))) {
+            candidates &= ~bit;
+          }
+        }
+        if (current == '\0') {
+          break;
+        }
       }
-      else if (strncmp_P(PROV_RESPONSE_TOPIC, topic, strlen(PROV_RESPONSE_TOPIC)) == 0) {
-        process_provisioning_response(topic, data);
+      return match;
+    }
+
+    /// @brief Whether anything is subscribed to messages of the given route, if not they are ignored without deserializing their payload
+    /// @param route Route of the received message
+    /// @return Whether the message has to be processed
+    inline bool Has_Route_Listener(const Topic_Route& route) const {
+      switch (route) {
+        case Topic_Route::RPC_RESPONSE:
+          return m_rpc_request_count != 0U;
+        case Topic_Route::RPC_REQUEST:
+          return !m_rpc_callbacks.empty();
+        case Topic_Route::ATTRIBUTE_RESPONSE:
+          return !m_attribute_request_callbacks.empty();
+        case Topic_Route::ATTRIBUTE:
+          return !m_shared_attribute_update_callbacks.empty();
+#if THINGSBOARD_ENABLE_OTA
+        case Topic_Route::FIRMWARE_RESPONSE:
+          return m_fw_callback != nullptr;
+#endif // THINGSBOARD_ENABLE_OTA
+        default:
+          return true;
       }
     }
 
@@ -2025,6 +2963,13 @@ class ThingsBoardSized {
       m_subscribedInstance->onMQTTMessage(topic, payload, length);
     }
 
+    static void onStaticMQTTDelivery(uint16_t message_id, bool delivered) {
+      if (m_subscribedInstance == nullptr) {
+        return;
+      }
+      m_subscribedInstance->onMQTTDelivery(message_id, delivered);
+    }
+
 #endif // !THINGSBOARD_ENABLE_STL
 
 };
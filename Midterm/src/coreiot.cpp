@@ -10,48 +10,49 @@ WiFiClient espClient;
 PubSubClient client(espClient);
 
 
-void reconnect() {
-  // Loop until we're reconnected
-  while (!client.connected()) {
-    Serial.print("Attempting MQTT connection...");
-    // Attempt to connect (username=token, password=empty)
-    if (client.connect("ESP32Client", coreIOT_Token, NULL)) {
-      Serial.println("connected to CoreIOT Server!");
-      client.subscribe("v1/devices/me/rpc/request/+");
-      Serial.println("Subscribed to v1/devices/me/rpc/request/+");
-
-    } else {
-      Serial.print("failed, rc=");
-      Serial.print(client.state());
-      Serial.println(" try again in 5 seconds");
-      delay(5000);
-    }
+#define MQTT_RETRY_INTERVAL_MS 5000
+#define TELEMETRY_INTERVAL_MS  10000     // live samples are taken on the same 10 s cadence as before the journal
+#define TELEMETRY_TOPIC        "v1/devices/me/telemetry"
+#define ARENA_REPORT_INTERVAL_MS 60000   // how often the JSON arena high water is checked and logged if it grew
+
+static uint32_t last_attempt_ms = 0;
+static bool attempted = false;
+
+// One connection attempt at most every MQTT_RETRY_INTERVAL_MS, so the task keeps
+// sampling into the journal instead of blocking for the whole outage.
+bool reconnect() {
+  if (client.connected()) {
+    return true;
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    return false;
+  }
+  if (attempted && millis() - last_attempt_ms < MQTT_RETRY_INTERVAL_MS) {
+    return false;
   }
+  attempted = true;
+  last_attempt_ms = millis();
+
+  Serial.print("Attempting MQTT connection...");
+  // Attempt to connect (username=token, password=empty)
+  if (client.connect("ESP32Client", coreIOT_Token, NULL)) {
+    Serial.println("connected to CoreIOT Server!");
+    client.subscribe("v1/devices/me/rpc/request/+");
+    Serial.println("Subscribed to v1/devices/me/rpc/request/+");
+    return true;
+  }
+  Serial.print("failed, rc=");
+  Serial.print(client.state());
+  Serial.println(" try again in 5 seconds");
+  return false;
 }
 
+static bool publish_batch(const char *payload, size_t length) {
+  return client.publish(TELEMETRY_TOPIC, (const uint8_t *)payload, length, false);
+}
 
-void callback(char* topic, byte* payload, unsigned int length) {
-  Serial.print("Message arrived [");
-  Serial.print(topic);
-  Serial.println("] ");
-
-  // Allocate a temporary buffer for the message
-  char message[length + 1];
-  memcpy(message, payload, length);
-  message[length] = '\0';
-  Serial.print("Payload: ");
-  Serial.println(message);
-
-  // Parse JSON
-  StaticJsonDocument<256> doc;
-  DeserializationError error = deserializeJson(doc, message);
-
-  if (error) {
-    Serial.print("deserializeJson() failed: ");
-    Serial.println(error.c_str());
-    return;
-  }
 
+static void handle_rpc(JsonDocument &doc) {
   const char* method = doc["method"];
   if (strcmp(method, "setStateLED") == 0) {
     // Check params type (could be boolean, int, or string according to your RPC)
@@ -74,6 +75,34 @@ void callback(char* topic, byte* payload, unsigned int length) {
 }
 
 
+void callback(char* topic, byte* payload, unsigned int length) {
+  Serial.print("Message arrived [");
+  Serial.print(topic);
+  Serial.println("] ");
+
+  Serial.print("Payload: ");
+  Serial.write(payload, length);
+  Serial.println();
+
+  JsonDocument *doc = json_arena_acquire();
+  if (doc == NULL) {
+    Serial.println("No free JSON arena, message dropped");
+    return;
+  }
+
+  // The payload sits in the client's receive buffer, which is writeable, so strings are parsed in place
+  DeserializationError error = deserializeJson(*doc, payload, length);
+
+  if (error) {
+    Serial.print("deserializeJson() failed: ");
+    Serial.println(error.c_str());
+  } else {
+    handle_rpc(*doc);
+  }
+  json_arena_release(doc);
+}
+
+
 void setup_coreiot(){
 
   //Serial.print("Connecting to WiFi...");
@@ -85,39 +114,91 @@ void setup_coreiot(){
   //   Serial.print(".");
   // }
 
-  while(1){
-    if (xSemaphoreTake(xBinarySemaphoreInternet, portMAX_DELAY)) {
-      break;
-    }
-    delay(500);
-    Serial.print(".");
-  }
-
+  // Wi-Fi is checked on every connection attempt; readings taken before the first
+  // connection go to the journal like any other outage.
+  configTime(0, 0, "pool.ntp.org", "time.google.com");
+  telemetry_journal_begin();
 
-  Serial.println(" Connected!");
+  // Defaults until the telemetryPolicy shared attribute overrides them
+  const ReportPolicy temperature_policy = {0.2f, 0.0f, 10000, 300000};
+  const ReportPolicy humidity_policy = {1.0f, 0.0f, 10000, 300000};
+  telemetry_filter_set_policy("temperature", temperature_policy);
+  telemetry_filter_set_policy("humidity", humidity_policy);
 
   client.setServer(coreIOT_Server, mqttPort);
   client.setCallback(callback);
+  client.setBufferSize(JOURNAL_BATCH_BYTES + 64);
 
 }
 
 void coreiot_task(void *pvParameters){
 
     setup_coreiot();
+    uint32_t last_sequence = 0;
+    uint32_t last_sample_ms = 0;
+    bool sampled = false;
+    uint32_t last_arena_report_ms = 0;
+    size_t reported_high_water = 0;
 
     while(1){
 
-        if (!client.connected()) {
-            reconnect();
+        bool online = reconnect();
+        if (online) {
+            client.loop();
         }
-        client.loop();
 
-        // Sample payload, publish to 'v1/devices/me/telemetry'
-        String payload = "{\"temperature\":" + String(glob_temperature) +  ",\"humidity\":" + String(glob_humidity) + "}";
-        
-        client.publish("v1/devices/me/telemetry", payload.c_str());
+        // The loop runs every 500 ms to serve MQTT and the journal, but a live sample is only
+        // taken every TELEMETRY_INTERVAL_MS, and only when the sensor task produced a new, valid one
+        bool sample_due = !sampled || millis() - last_sample_ms >= TELEMETRY_INTERVAL_MS;
+        SensorSnapshot snapshot;
+        if (sample_due && sensor_snapshot_read_newer(last_sequence, snapshot) && snapshot.valid) {
+            sampled = true;
+            last_sample_ms = millis();
+
+            // Report by exception: only keys whose policy says the change matters
+            bool report_temperature = telemetry_filter_should_report("temperature", snapshot.temperature);
+            bool report_humidity = telemetry_filter_should_report("humidity", snapshot.humidity);
+
+            char values[64];
+            if (report_temperature && report_humidity) {
+                snprintf(values, sizeof(values), "{\"temperature\":%.2f,\"humidity\":%.2f}", snapshot.temperature, snapshot.humidity);
+            } else if (report_temperature) {
+                snprintf(values, sizeof(values), "{\"temperature\":%.2f}", snapshot.temperature);
+            } else if (report_humidity) {
+                snprintf(values, sizeof(values), "{\"humidity\":%.2f}", snapshot.humidity);
+            } else {
+                values[0] = '\0';
+            }
+
+            // Live samples go straight out; anything that cannot be sent is journaled with its timestamp
+            if (values[0] != '\0') {
+                if (online && client.publish(TELEMETRY_TOPIC, values)) {
+                    Serial.print("Published payload: ");
+                    Serial.println(values);
+                } else {
+                    telemetry_journal_append(epoch_ms(), values);
+                }
+            }
+        }
+
+        // Backlog goes out one rate-limited batch at a time, after the live sample
+        if (online && !telemetry_journal_empty()) {
+            size_t sent = telemetry_journal_drain(publish_batch);
+            if (sent > 0) {
+                Serial.printf("Journal: sent %u buffered records\n", (unsigned)sent);
+            }
+        }
+
+        // Shows how close inbound messages get to JSON_ARENA_BYTES, only when a larger message was seen
+        if (millis() - last_arena_report_ms >= ARENA_REPORT_INTERVAL_MS) {
+            last_arena_report_ms = millis();
+            size_t high_water = json_arena_high_water();
+            if (high_water > reported_high_water) {
+                reported_high_water = high_water;
+                Serial.printf("JSON arena: high water %u of %u bytes\n", (unsigned)high_water, (unsigned)JSON_ARENA_BYTES);
+            }
+        }
 
-        Serial.println("Published payload: " + payload);
-        vTaskDelay(10000);  // Publish every 10 seconds
+        vTaskDelay(500 / portTICK_PERIOD_MS);
     }
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+#include "epoch_time.h"
+#include <sys/time.h>
+
+// Anything before 2020 is the unsynced clock counting from boot
+#define EPOCH_SYNCED_AFTER_S 1600000000
+
+int64_t epoch_ms()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec < EPOCH_SYNCED_AFTER_S)
+    {
+        return 0;
+    }
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
@@ -1,6 +1,4 @@
 #include "global.h"
-float glob_temperature = 0;
-float glob_humidity = 0;
 
 String WIFI_SSID;
 String WIFI_PASS;
@@ -0,0 +1,168 @@
+#include "i2c_bus.h"
+#include "esp_timer.h"
+
+// Lives on the stack of the submitting task, which sleeps on done until the bus task gives it
+typedef struct {
+    uint8_t           address;
+    const uint8_t     *tx;
+    size_t            tx_len;
+    uint8_t           *rx;
+    size_t            rx_len;
+    int64_t           submitted_us;
+    volatile int      status;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buffer;
+} I2cRequest;
+
+static QueueHandle_t bus_queue[I2C_PRIORITY_COUNT] = {NULL, NULL};
+static TaskHandle_t bus_task = NULL;
+
+static I2cBusStats bus_stats;
+static int64_t window_start_us = 0;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static int run_request(const I2cRequest &req)
+{
+    if (req.tx_len > 0 || req.rx_len == 0)
+    {
+        Wire.beginTransmission(req.address);
+        if (req.tx_len > 0)
+        {
+            Wire.write(req.tx, req.tx_len);
+        }
+        // Repeated start when a read follows
+        uint8_t error = Wire.endTransmission(req.rx_len == 0);
+        if (error != 0)
+        {
+            return error;
+        }
+    }
+    if (req.rx_len > 0)
+    {
+        size_t received = Wire.requestFrom(req.address, (uint8_t)req.rx_len);
+        for (size_t i = 0; i < received && i < req.rx_len; i++)
+        {
+            req.rx[i] = Wire.read();
+        }
+        if (received < req.rx_len)
+        {
+            return I2C_BUS_ERROR_READ;
+        }
+    }
+    return I2C_BUS_OK;
+}
+
+static void i2c_bus_task(void *pvParameters)
+{
+    while (1)
+    {
+        // One notification per submitted request
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+        I2cRequest *req = NULL;
+        I2cPriority priority = I2C_PRIORITY_HIGH;
+        if (xQueueReceive(bus_queue[I2C_PRIORITY_HIGH], &req, 0) != pdTRUE)
+        {
+            priority = I2C_PRIORITY_LOW;
+            if (xQueueReceive(bus_queue[I2C_PRIORITY_LOW], &req, 0) != pdTRUE)
+            {
+                continue;
+            }
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        int status = run_request(*req);
+        int64_t end_us = esp_timer_get_time();
+
+        uint32_t latency = (uint32_t)(end_us - req->submitted_us);
+        portENTER_CRITICAL(&stats_mux);
+        bus_stats.transactions[priority]++;
+        bus_stats.total_latency_us[priority] += latency;
+        if (latency > bus_stats.max_latency_us[priority])
+        {
+            bus_stats.max_latency_us[priority] = latency;
+        }
+        bus_stats.busy_us += end_us - start_us;
+        if (status != I2C_BUS_OK)
+        {
+            bus_stats.errors++;
+        }
+        portEXIT_CRITICAL(&stats_mux);
+
+        // req is gone as soon as the waiter takes done, nothing may touch it afterwards
+        req->status = status;
+        xSemaphoreGive(req->done);
+    }
+}
+
+bool i2c_bus_begin(int sda, int scl, uint32_t clock_hz)
+{
+    if (bus_task != NULL)
+    {
+        return true;
+    }
+    if (!Wire.begin(sda, scl, clock_hz))
+    {
+        return false;
+    }
+    for (int i = 0; i < I2C_PRIORITY_COUNT; i++)
+    {
+        bus_queue[i] = xQueueCreate(I2C_BUS_QUEUE_LENGTH, sizeof(I2cRequest *));
+        if (bus_queue[i] == NULL)
+        {
+            return false;
+        }
+    }
+    window_start_us = esp_timer_get_time();
+    return xTaskCreate(i2c_bus_task, "i2c_bus", I2C_BUS_TASK_STACK, NULL, I2C_BUS_TASK_PRIORITY, &bus_task) == pdPASS;
+}
+
+int i2c_bus_transfer(uint8_t address, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len, I2cPriority priority)
+{
+    if (bus_task == NULL || priority >= I2C_PRIORITY_COUNT)
+    {
+        return I2C_BUS_ERROR_QUEUE;
+    }
+
+    I2cRequest req;
+    req.address = address;
+    req.tx = tx;
+    req.tx_len = tx_len;
+    req.rx = rx;
+    req.rx_len = rx_len;
+    req.submitted_us = esp_timer_get_time();
+    req.status = I2C_BUS_OK;
+    // Per-request semaphore, the caller's task notification stays free for its own use
+    // (the DHT20 ready timer) and is neither consumed nor raised by a transfer
+    req.done = xSemaphoreCreateBinaryStatic(&req.done_buffer);
+
+    I2cRequest *ptr = &req;
+    if (xQueueSend(bus_queue[priority], &ptr, portMAX_DELAY) != pdTRUE)
+    {
+        return I2C_BUS_ERROR_QUEUE;
+    }
+    xTaskNotifyGive(bus_task);
+
+    // The request lives on this stack, so never return before the bus task is done with it
+    xSemaphoreTake(req.done, portMAX_DELAY);
+    return req.status;
+}
+
+int i2c_bus_transfer_hook(uint8_t address, const uint8_t *tx, uint8_t tx_len, uint8_t *rx, uint8_t rx_len, void *ctx)
+{
+    return i2c_bus_transfer(address, tx, tx_len, rx, rx_len, (I2cPriority)(uintptr_t)ctx);
+}
+
+void i2c_bus_get_stats(I2cBusStats &out, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&stats_mux);
+    out = bus_stats;
+    out.window_us = now - window_start_us;
+    if (reset)
+    {
+        memset(&bus_stats, 0, sizeof(bus_stats));
+        window_start_us = now;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+}
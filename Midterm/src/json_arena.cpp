@@ -0,0 +1,43 @@
+#include "json_arena.h"
+#include <atomic>
+
+static StaticJsonDocument<JSON_ARENA_BYTES> arenas[JSON_ARENA_SLOTS];
+static std::atomic<bool> arena_busy[JSON_ARENA_SLOTS];
+static std::atomic<size_t> arena_high_water(0);
+
+JsonDocument *json_arena_acquire()
+{
+    for (size_t i = 0; i < JSON_ARENA_SLOTS; i++)
+    {
+        bool expected = false;
+        if (arena_busy[i].compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            return &arenas[i];
+        }
+    }
+    return NULL;
+}
+
+void json_arena_release(JsonDocument *doc)
+{
+    for (size_t i = 0; i < JSON_ARENA_SLOTS; i++)
+    {
+        if (doc != &arenas[i])
+        {
+            continue;
+        }
+        size_t used = doc->memoryUsage();
+        size_t seen = arena_high_water.load(std::memory_order_relaxed);
+        while (used > seen && !arena_high_water.compare_exchange_weak(seen, used, std::memory_order_relaxed))
+        {
+        }
+        doc->clear();
+        arena_busy[i].store(false, std::memory_order_release);
+        return;
+    }
+}
+
+size_t json_arena_high_water()
+{
+    return arena_high_water.load(std::memory_order_relaxed);
+}
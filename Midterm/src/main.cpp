@@ -21,15 +21,20 @@ void temp_humi_monitor(void *pvParameters){
         
 
         // Check if any reads failed and exit early
+        bool valid = true;
         if (isnan(temperature) || isnan(humidity)) {
             Serial.println("Failed to read from DHT sensor!");
             temperature = humidity =  -1;
+            valid = false;
             //return;
         }
 
-        //Update global variables for temperature and humidity
-        glob_temperature = temperature;
-        glob_humidity = humidity;
+        //Publish temperature and humidity as one consistent snapshot
+        sensor_snapshot_publish(temperature, humidity, valid);
+        if (valid) {
+            sensor_history_record(SENSOR_TEMPERATURE, temperature);
+            sensor_history_record(SENSOR_HUMIDITY, humidity);
+        }
 
         // Print the results
         
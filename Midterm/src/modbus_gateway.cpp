@@ -0,0 +1,510 @@
+#include "modbus_gateway.h"
+#include "relay_controller.h"
+#include <atomic>
+
+#define MBAP_HEADER                 7       // transaction, protocol, length, unit
+#define MBAP_MAX_FRAME              (MBAP_HEADER + MODBUS_MAX_PDU)
+#define EXCEPTION_BUSY              0x06
+#define EXCEPTION_PATH_UNAVAILABLE  0x0A
+#define EXCEPTION_TARGET_FAILED     0x0B
+
+typedef struct {
+    WiFiClient client;
+    bool       active;
+    uint32_t   generation;      // bumped on every new connection in this slot
+    uint8_t    rx[MBAP_MAX_FRAME];
+    size_t     rx_length;
+} GatewayClient;
+
+typedef enum {
+    TX_FREE = 0,
+    TX_WAITING,
+    TX_ON_BUS
+} TransactionState;
+
+typedef struct {
+    TransactionState state;
+    uint32_t seq;               // arrival order
+    uint8_t  client;
+    uint32_t generation;
+    uint16_t transaction_id;
+    uint8_t  unit;
+    uint8_t  pdu[MODBUS_MAX_PDU];
+    uint8_t  pdu_length;
+    uint32_t op;                // bus request answering this transaction
+    uint32_t epoch;             // write_epoch when that request was submitted
+} GatewayTransaction;
+
+// Posted by the bus task, handled by the gateway task
+typedef struct {
+    uint32_t op;
+    int      status;
+    uint8_t  exception;
+    uint8_t  length;
+    uint8_t  data[MODBUS_MAX_PDU - 1];
+} GatewayResult;
+
+typedef struct {
+    bool     valid;
+    uint8_t  unit;
+    uint8_t  request[5];        // function, address, quantity
+    uint8_t  length;
+    uint8_t  data[MODBUS_MAX_PDU - 1];
+    uint32_t stamp_ms;
+    uint32_t epoch;
+} CacheEntry;
+
+static ModbusMaster *gateway_bus = NULL;
+static WiFiServer server(GATEWAY_PORT);
+static bool listening = false;
+static QueueHandle_t results = NULL;
+static GatewayClient clients[GATEWAY_MAX_CLIENTS];
+static GatewayTransaction transactions[GATEWAY_MAX_PENDING];
+static CacheEntry cache[GATEWAY_CACHE_ENTRIES];
+static uint8_t inflight[248];   // requests per slave queued on the master
+static uint32_t next_seq = 0;
+static uint32_t next_op = 0;
+static GatewayStats gateway_stats;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Bumped by writes that reach the bus without going through the gateway. Cache entries and
+// replies to reads submitted before the bump are not used afterwards.
+static std::atomic<uint32_t> write_epoch(0);
+
+static bool is_cacheable(const uint8_t *pdu, size_t length)
+{
+    return length == 5 && pdu[0] >= MODBUS_READ_COILS && pdu[0] <= MODBUS_READ_INPUT;
+}
+
+static void count(uint32_t GatewayStats::*field)
+{
+    portENTER_CRITICAL(&stats_mux);
+    gateway_stats.*field += 1;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+static void respond(uint8_t slot, uint32_t generation, uint16_t transaction_id, uint8_t unit,
+                    const uint8_t *pdu, size_t length)
+{
+    GatewayClient &gc = clients[slot];
+    if (!gc.active || gc.generation != generation)
+    {
+        return;     // the client left while its request was on the bus
+    }
+    uint8_t frame[MBAP_MAX_FRAME];
+    frame[0] = transaction_id >> 8;
+    frame[1] = transaction_id;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = (length + 1) >> 8;
+    frame[5] = length + 1;
+    frame[6] = unit;
+    memcpy(frame + MBAP_HEADER, pdu, length);
+    gc.client.write(frame, MBAP_HEADER + length);
+}
+
+static void respond_exception(uint8_t slot, uint32_t generation, uint16_t transaction_id, uint8_t unit,
+                              uint8_t function, uint8_t code)
+{
+    uint8_t pdu[2] = {(uint8_t)(function | 0x80), code};
+    respond(slot, generation, transaction_id, unit, pdu, sizeof(pdu));
+}
+
+static CacheEntry *cache_lookup(uint8_t unit, const uint8_t *pdu)
+{
+    uint32_t now = millis();
+    for (int i = 0; i < GATEWAY_CACHE_ENTRIES; i++)
+    {
+        CacheEntry &entry = cache[i];
+        if (entry.valid && entry.unit == unit && memcmp(entry.request, pdu, 5) == 0 &&
+            now - entry.stamp_ms < GATEWAY_CACHE_TTL_MS && entry.epoch == write_epoch.load())
+        {
+            return &entry;
+        }
+    }
+    return NULL;
+}
+
+static void cache_store(uint8_t unit, const uint8_t *pdu, const uint8_t *data, uint8_t length, uint32_t epoch)
+{
+    // Same request, else a free or expired entry, else the oldest
+    CacheEntry *slot = NULL;
+    uint32_t now = millis();
+    for (int i = 0; i < GATEWAY_CACHE_ENTRIES; i++)
+    {
+        CacheEntry &entry = cache[i];
+        if (entry.valid && entry.unit == unit && memcmp(entry.request, pdu, 5) == 0)
+        {
+            slot = &entry;
+            break;
+        }
+        bool expired = !entry.valid || now - entry.stamp_ms >= GATEWAY_CACHE_TTL_MS;
+        bool slot_expired = slot != NULL && (!slot->valid || now - slot->stamp_ms >= GATEWAY_CACHE_TTL_MS);
+        if (slot == NULL || (expired && !slot_expired) ||
+            (expired == slot_expired && now - entry.stamp_ms > now - slot->stamp_ms))
+        {
+            slot = &entry;
+        }
+    }
+    slot->valid = true;
+    slot->unit = unit;
+    memcpy(slot->request, pdu, 5);
+    slot->length = length;
+    memcpy(slot->data, data, length);
+    slot->stamp_ms = now;
+    slot->epoch = epoch;
+}
+
+// After a write the cached reads of that slave may be stale
+static void cache_invalidate(uint8_t unit)
+{
+    for (int i = 0; i < GATEWAY_CACHE_ENTRIES; i++)
+    {
+        if (cache[i].unit == unit)
+        {
+            cache[i].valid = false;
+        }
+    }
+}
+
+// A write for the unit that is queued or on the bus; reads behind it must not be answered
+// from the cache or from a read started before it
+static bool write_pending(uint8_t unit)
+{
+    for (int i = 0; i < GATEWAY_MAX_PENDING; i++)
+    {
+        const GatewayTransaction &tx = transactions[i];
+        if (tx.state != TX_FREE && tx.unit == unit && !is_cacheable(tx.pdu, tx.pdu_length))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void handle_frame(uint8_t slot, const uint8_t *frame, size_t length)
+{
+    GatewayClient &gc = clients[slot];
+    uint16_t transaction_id = (frame[0] << 8) | frame[1];
+    uint8_t unit = frame[6];
+    const uint8_t *pdu = frame + MBAP_HEADER;
+    size_t pdu_length = length - MBAP_HEADER;
+    count(&GatewayStats::requests);
+
+    if (unit == MODBUS_BROADCAST || unit > 247)
+    {
+        respond_exception(slot, gc.generation, transaction_id, unit, pdu[0], EXCEPTION_PATH_UNAVAILABLE);
+        return;
+    }
+    if (is_cacheable(pdu, pdu_length) && !write_pending(unit))
+    {
+        CacheEntry *entry = cache_lookup(unit, pdu);
+        if (entry != NULL)
+        {
+            uint8_t reply[MODBUS_MAX_PDU];
+            reply[0] = pdu[0];
+            memcpy(reply + 1, entry->data, entry->length);
+            respond(slot, gc.generation, transaction_id, unit, reply, entry->length + 1);
+            count(&GatewayStats::cache_hits);
+            return;
+        }
+    }
+
+    for (int i = 0; i < GATEWAY_MAX_PENDING; i++)
+    {
+        GatewayTransaction &tx = transactions[i];
+        if (tx.state == TX_FREE)
+        {
+            tx.state = TX_WAITING;
+            tx.seq = next_seq++;
+            tx.client = slot;
+            tx.generation = gc.generation;
+            tx.transaction_id = transaction_id;
+            tx.unit = unit;
+            memcpy(tx.pdu, pdu, pdu_length);
+            tx.pdu_length = pdu_length;
+            return;
+        }
+    }
+    respond_exception(slot, gc.generation, transaction_id, unit, pdu[0], EXCEPTION_BUSY);
+    count(&GatewayStats::busy_rejects);
+}
+
+static void service_clients()
+{
+    WiFiClient incoming = server.available();
+    if (incoming)
+    {
+        int free_slot = -1;
+        for (int i = 0; i < GATEWAY_MAX_CLIENTS && free_slot < 0; i++)
+        {
+            if (!clients[i].active)
+            {
+                free_slot = i;
+            }
+        }
+        if (free_slot < 0)
+        {
+            incoming.stop();
+        }
+        else
+        {
+            GatewayClient &gc = clients[free_slot];
+            gc.client = incoming;
+            gc.client.setNoDelay(true);
+            gc.active = true;
+            gc.generation++;
+            gc.rx_length = 0;
+        }
+    }
+
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++)
+    {
+        GatewayClient &gc = clients[i];
+        if (!gc.active)
+        {
+            continue;
+        }
+        if (!gc.client.connected())
+        {
+            gc.client.stop();
+            gc.active = false;
+            continue;
+        }
+        int available = gc.client.available();
+        while (available > 0 && gc.active)
+        {
+            int n = gc.client.read(gc.rx + gc.rx_length, sizeof(gc.rx) - gc.rx_length);
+            if (n <= 0)
+            {
+                break;
+            }
+            gc.rx_length += n;
+            available -= n;
+
+            // Every complete frame in the buffer
+            while (gc.rx_length >= MBAP_HEADER)
+            {
+                uint16_t protocol = (gc.rx[2] << 8) | gc.rx[3];
+                uint16_t length = (gc.rx[4] << 8) | gc.rx[5];
+                if (protocol != 0 || length < 2 || length > MODBUS_MAX_PDU + 1)
+                {
+                    // Lost framing, nothing after this can be trusted
+                    gc.client.stop();
+                    gc.active = false;
+                    break;
+                }
+                size_t frame_length = 6 + length;
+                if (gc.rx_length < frame_length)
+                {
+                    break;
+                }
+                handle_frame(i, gc.rx, frame_length);
+                memmove(gc.rx, gc.rx + frame_length, gc.rx_length - frame_length);
+                gc.rx_length -= frame_length;
+            }
+        }
+    }
+}
+
+static void bus_done(const ModbusResult &result, void *ctx)
+{
+    GatewayResult msg;
+    msg.op = (uint32_t)(uintptr_t)ctx;
+    msg.status = result.status;
+    msg.exception = result.exception;
+    msg.length = 0;
+    if (result.status == MODBUS_OK && result.length <= sizeof(msg.data))
+    {
+        msg.length = result.length;
+        memcpy(msg.data, result.data, result.length);
+    }
+    // Never more results than pending transactions, so this does not block
+    xQueueSend(results, &msg, portMAX_DELAY);
+}
+
+static void dispatch()
+{
+    // Waiting transactions in arrival order
+    uint8_t order[GATEWAY_MAX_PENDING];
+    size_t waiting = 0;
+    for (int i = 0; i < GATEWAY_MAX_PENDING; i++)
+    {
+        if (transactions[i].state != TX_WAITING)
+        {
+            continue;
+        }
+        size_t j = waiting++;
+        while (j > 0 && transactions[order[j - 1]].seq > transactions[i].seq)
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    for (size_t w = 0; w < waiting; w++)
+    {
+        GatewayTransaction &tx = transactions[order[w]];
+
+        // The same read already on the bus answers this one too, unless a write to the
+        // slave is pending: the read on the bus may have been sent before it
+        if (is_cacheable(tx.pdu, tx.pdu_length) && !write_pending(tx.unit))
+        {
+            bool joined = false;
+            for (int i = 0; i < GATEWAY_MAX_PENDING && !joined; i++)
+            {
+                GatewayTransaction &other = transactions[i];
+                if (other.state == TX_ON_BUS && other.unit == tx.unit && other.pdu_length == tx.pdu_length &&
+                    memcmp(other.pdu, tx.pdu, tx.pdu_length) == 0)
+                {
+                    tx.state = TX_ON_BUS;
+                    tx.op = other.op;
+                    tx.epoch = other.epoch;
+                    joined = true;
+                }
+            }
+            if (joined)
+            {
+                count(&GatewayStats::coalesced);
+                continue;
+            }
+        }
+
+        if (inflight[tx.unit] >= GATEWAY_PER_SLAVE)
+        {
+            continue;
+        }
+        ModbusRequest request;
+        modbus_request_init(request, tx.unit, tx.pdu[0], tx.pdu + 1, tx.pdu_length - 1);
+        request.callback = bus_done;
+        request.ctx = (void *)(uintptr_t)next_op;
+        uint32_t epoch = write_epoch.load();
+        if (!modbus_master_submit(gateway_bus, request, 0))
+        {
+            break;  // master queue full, try again next round
+        }
+        tx.state = TX_ON_BUS;
+        tx.op = next_op++;
+        tx.epoch = epoch;
+        inflight[tx.unit]++;
+        count(&GatewayStats::bus_requests);
+    }
+}
+
+static void complete(const GatewayResult &msg)
+{
+    uint8_t reply[MODBUS_MAX_PDU];
+    bool first = true;
+    for (int i = 0; i < GATEWAY_MAX_PENDING; i++)
+    {
+        GatewayTransaction &tx = transactions[i];
+        if (tx.state != TX_ON_BUS || tx.op != msg.op)
+        {
+            continue;
+        }
+        size_t length;
+        reply[0] = tx.pdu[0];
+        if (msg.status == MODBUS_OK)
+        {
+            memcpy(reply + 1, msg.data, msg.length);
+            length = msg.length + 1;
+        }
+        else
+        {
+            reply[0] |= 0x80;
+            reply[1] = msg.status == MODBUS_ERROR_EXCEPTION ? msg.exception : EXCEPTION_TARGET_FAILED;
+            length = 2;
+        }
+
+        if (first)
+        {
+            first = false;
+            inflight[tx.unit]--;
+            if (msg.status == MODBUS_OK)
+            {
+                if (is_cacheable(tx.pdu, tx.pdu_length))
+                {
+                    // Only if no outside write happened since the read was submitted
+                    if (tx.epoch == write_epoch.load())
+                    {
+                        cache_store(tx.unit, tx.pdu, msg.data, msg.length, tx.epoch);
+                    }
+                }
+                else
+                {
+                    cache_invalidate(tx.unit);
+                }
+            }
+            // A write to the relay board, even a failed one, may have switched coils the
+            // relay controller still believes in
+            if (tx.unit == RELAY_SLAVE && !is_cacheable(tx.pdu, tx.pdu_length))
+            {
+                relay_controller_invalidate();
+            }
+        }
+        respond(tx.client, tx.generation, tx.transaction_id, tx.unit, reply, length);
+        tx.state = TX_FREE;
+    }
+}
+
+static void modbus_gateway_task(void *pvParameters)
+{
+    GatewayResult msg;
+    while (1)
+    {
+        if (!listening)
+        {
+            if (WiFi.status() != WL_CONNECTED)
+            {
+                vTaskDelay(pdMS_TO_TICKS(500));
+                continue;
+            }
+            server.begin();
+            server.setNoDelay(true);
+            listening = true;
+        }
+
+        service_clients();
+        dispatch();
+        if (xQueueReceive(results, &msg, pdMS_TO_TICKS(GATEWAY_POLL_MS)) == pdTRUE)
+        {
+            do
+            {
+                complete(msg);
+            } while (xQueueReceive(results, &msg, 0) == pdTRUE);
+            dispatch();
+        }
+    }
+}
+
+bool modbus_gateway_begin(ModbusMaster *bus)
+{
+    if (bus == NULL || gateway_bus != NULL)
+    {
+        return false;
+    }
+    results = xQueueCreate(GATEWAY_MAX_PENDING, sizeof(GatewayResult));
+    if (results == NULL)
+    {
+        return false;
+    }
+    gateway_bus = bus;
+    return xTaskCreate(modbus_gateway_task, "modbus_gw", GATEWAY_TASK_STACK, NULL, GATEWAY_TASK_PRIORITY, NULL) == pdPASS;
+}
+
+void modbus_gateway_invalidate_cache()
+{
+    write_epoch.fetch_add(1);
+}
+
+void modbus_gateway_get_stats(GatewayStats &out, bool reset)
+{
+    portENTER_CRITICAL(&stats_mux);
+    out = gateway_stats;
+    if (reset)
+    {
+        memset(&gateway_stats, 0, sizeof(gateway_stats));
+    }
+    portEXIT_CRITICAL(&stats_mux);
+}
@@ -0,0 +1,377 @@
+#include "modbus_master.h"
+#include "modbus_frame.h"
+#include "esp_timer.h"
+
+struct ModbusMaster {
+    const ModbusTransport *transport;
+    QueueHandle_t         queue;
+    TaskHandle_t          task;
+    ModbusStats           stats;
+    portMUX_TYPE          stats_mux;
+};
+
+// Queue item: the request plus its submit time for the latency statistics
+typedef struct {
+    ModbusRequest request;
+    int64_t       submitted_us;
+} ModbusJob;
+
+// Lives on the stack of a task blocked in modbus_master_transact, which sleeps on done
+typedef struct {
+    uint8_t           *data;
+    size_t            size;
+    size_t            length;
+    volatile int      status;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buffer;
+} ModbusWait;
+
+uint16_t modbus_crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    while (length--)
+    {
+        crc = (crc >> 8) ^ modbus::crc_table::values[(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+// Checks a reply against the request it answers. On success result points into reply.
+static int check_reply(const ModbusRequest &request, const uint8_t *reply, size_t length, ModbusResult &result)
+{
+    if (length < 4)
+    {
+        return MODBUS_ERROR_FRAME;
+    }
+    uint16_t crc = reply[length - 2] | (reply[length - 1] << 8);
+    if (crc != modbus_crc16(reply, length - 2))
+    {
+        return MODBUS_ERROR_CRC;
+    }
+    if (reply[0] != request.frame[0] || (reply[1] & 0x7F) != request.frame[1])
+    {
+        return MODBUS_ERROR_FRAME;
+    }
+    if (reply[1] & 0x80)
+    {
+        if (length != 5)
+        {
+            return MODBUS_ERROR_FRAME;
+        }
+        result.exception = reply[2];
+        return MODBUS_ERROR_EXCEPTION;
+    }
+
+    switch (reply[1])
+    {
+    case MODBUS_READ_COILS:
+    case 0x02:
+    case MODBUS_READ_HOLDING:
+    case MODBUS_READ_INPUT:
+        // slave, function, byte count, data, CRC
+        if (length < 5 || reply[2] != length - 5)
+        {
+            return MODBUS_ERROR_FRAME;
+        }
+        break;
+    case MODBUS_WRITE_COIL:
+    case MODBUS_WRITE_REGISTER:
+    case MODBUS_WRITE_COILS:
+    case MODBUS_WRITE_REGISTERS:
+        // echo of address and value / quantity
+        if (length != 8)
+        {
+            return MODBUS_ERROR_FRAME;
+        }
+        break;
+    default:
+        break;
+    }
+    result.data = reply + 2;
+    result.length = length - 4;
+    return MODBUS_OK;
+}
+
+static void run_job(ModbusMaster *bus, const ModbusJob &job)
+{
+    const ModbusRequest &request = job.request;
+    const ModbusTransport *transport = bus->transport;
+    const uint8_t *reply = NULL;
+    uint32_t retries = 0;
+    uint32_t timeouts = 0;
+    uint32_t crc_errors = 0;
+    uint32_t frame_errors = 0;
+
+    ModbusResult result;
+    result.slave = request.frame[0];
+    result.function = request.frame[1];
+    result.exception = 0;
+    result.data = NULL;
+    result.length = 0;
+    result.status = MODBUS_ERROR_SEND;
+
+    for (uint8_t attempt = 0; attempt <= request.retries; attempt++)
+    {
+        if (attempt > 0)
+        {
+            retries++;
+        }
+        if (reply != NULL)
+        {
+            transport->release(transport->ctx, reply);
+            reply = NULL;
+        }
+        if (!transport->send(transport->ctx, request.frame, request.length))
+        {
+            result.status = MODBUS_ERROR_SEND;
+            continue;
+        }
+        if (request.frame[0] == MODBUS_BROADCAST)
+        {
+            // Nobody answers a broadcast; give the slaves time to act on it
+            vTaskDelay(pdMS_TO_TICKS(MODBUS_BROADCAST_DELAY_MS));
+            result.status = MODBUS_OK;
+            break;
+        }
+
+        size_t length = 0;
+        reply = transport->receive(transport->ctx, &length, request.timeout_ms);
+        if (reply == NULL)
+        {
+            result.status = MODBUS_ERROR_TIMEOUT;
+            timeouts++;
+            continue;
+        }
+        result.status = check_reply(request, reply, length, result);
+        if (result.status == MODBUS_ERROR_CRC)
+        {
+            crc_errors++;
+        }
+        else if (result.status == MODBUS_ERROR_FRAME)
+        {
+            frame_errors++;
+        }
+        else
+        {
+            // A valid reply, or an exception, which a retry would only repeat
+            break;
+        }
+    }
+
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - job.submitted_us);
+    portENTER_CRITICAL(&bus->stats_mux);
+    bus->stats.requests++;
+    bus->stats.retries += retries;
+    bus->stats.timeouts += timeouts;
+    bus->stats.crc_errors += crc_errors;
+    bus->stats.frame_errors += frame_errors;
+    if (result.status == MODBUS_ERROR_EXCEPTION)
+    {
+        bus->stats.exceptions++;
+    }
+    if (latency > bus->stats.max_latency_us)
+    {
+        bus->stats.max_latency_us = latency;
+    }
+    portEXIT_CRITICAL(&bus->stats_mux);
+
+    if (request.callback != NULL)
+    {
+        request.callback(result, request.ctx);
+    }
+    // result.data points into the transport buffer until here
+    if (reply != NULL)
+    {
+        transport->release(transport->ctx, reply);
+    }
+}
+
+static void modbus_master_task(void *pvParameters)
+{
+    ModbusMaster *bus = (ModbusMaster *)pvParameters;
+    ModbusJob job;
+    while (1)
+    {
+        if (xQueueReceive(bus->queue, &job, portMAX_DELAY) == pdTRUE)
+        {
+            run_job(bus, job);
+        }
+    }
+}
+
+ModbusMaster *modbus_master_begin(const ModbusTransport *transport, const char *name)
+{
+    if (transport == NULL || transport->send == NULL || transport->receive == NULL || transport->release == NULL)
+    {
+        return NULL;
+    }
+    ModbusMaster *bus = new ModbusMaster();
+    bus->transport = transport;
+    bus->stats_mux = portMUX_INITIALIZER_UNLOCKED;
+    bus->queue = xQueueCreate(MODBUS_QUEUE_LENGTH, sizeof(ModbusJob));
+    if (bus->queue == NULL)
+    {
+        delete bus;
+        return NULL;
+    }
+    if (xTaskCreate(modbus_master_task, name, MODBUS_TASK_STACK, bus, MODBUS_TASK_PRIORITY, &bus->task) != pdPASS)
+    {
+        vQueueDelete(bus->queue);
+        delete bus;
+        return NULL;
+    }
+    return bus;
+}
+
+bool modbus_request_init(ModbusRequest &request, uint8_t slave, uint8_t function,
+                         const uint8_t *data, size_t length)
+{
+    if (length + 1 > MODBUS_MAX_PDU)
+    {
+        return false;
+    }
+    request.frame[0] = slave;
+    request.frame[1] = function;
+    if (length > 0)
+    {
+        memcpy(request.frame + 2, data, length);
+    }
+    uint16_t crc = modbus_crc16(request.frame, length + 2);
+    request.frame[length + 2] = crc & 0xFF;
+    request.frame[length + 3] = crc >> 8;
+    request.length = length + 4;
+    request.timeout_ms = MODBUS_DEFAULT_TIMEOUT_MS;
+    request.retries = MODBUS_DEFAULT_RETRIES;
+    request.callback = NULL;
+    request.ctx = NULL;
+    return true;
+}
+
+bool modbus_request_init_frame(ModbusRequest &request, const uint8_t *frame, size_t length)
+{
+    if (length < 4 || length > MODBUS_MAX_ADU)
+    {
+        return false;
+    }
+    memcpy(request.frame, frame, length);
+    request.length = length;
+    request.timeout_ms = MODBUS_DEFAULT_TIMEOUT_MS;
+    request.retries = MODBUS_DEFAULT_RETRIES;
+    request.callback = NULL;
+    request.ctx = NULL;
+    return true;
+}
+
+bool modbus_master_submit(ModbusMaster *bus, const ModbusRequest &request, TickType_t wait)
+{
+    if (bus == NULL || request.length < 4 || request.length > MODBUS_MAX_ADU)
+    {
+        return false;
+    }
+    ModbusJob job;
+    job.request = request;
+    job.submitted_us = esp_timer_get_time();
+    return xQueueSend(bus->queue, &job, wait) == pdTRUE;
+}
+
+static void wake_waiter(const ModbusResult &result, void *ctx)
+{
+    ModbusWait *wait = (ModbusWait *)ctx;
+    wait->length = 0;
+    if (result.status == MODBUS_OK && wait->data != NULL)
+    {
+        wait->length = result.length < wait->size ? result.length : wait->size;
+        memcpy(wait->data, result.data, wait->length);
+    }
+    else if (result.status == MODBUS_ERROR_EXCEPTION && wait->data != NULL && wait->size > 0)
+    {
+        wait->data[0] = result.exception;
+        wait->length = 1;
+    }
+    // wait is gone as soon as the waiter takes done, nothing may touch it afterwards
+    wait->status = result.status;
+    xSemaphoreGive(wait->done);
+}
+
+int modbus_master_transact(ModbusMaster *bus, ModbusRequest &request, uint8_t *data, size_t size, size_t *length)
+{
+    ModbusWait wait;
+    wait.data = data;
+    wait.size = size;
+    wait.length = 0;
+    wait.status = MODBUS_ERROR_QUEUE;
+    // Per-call semaphore, the caller's task notification stays free for its own use
+    wait.done = xSemaphoreCreateBinaryStatic(&wait.done_buffer);
+
+    request.callback = wake_waiter;
+    request.ctx = &wait;
+    if (!modbus_master_submit(bus, request))
+    {
+        return MODBUS_ERROR_QUEUE;
+    }
+    xSemaphoreTake(wait.done, portMAX_DELAY);
+    if (length != NULL)
+    {
+        *length = wait.length;
+    }
+    return wait.status;
+}
+
+static int read_registers(ModbusMaster *bus, ModbusRequest &request, uint16_t count, uint16_t *values)
+{
+    uint8_t reply[1 + 250];
+    size_t length = 0;
+    int status = modbus_master_transact(bus, request, reply, sizeof(reply), &length);
+    if (status != MODBUS_OK)
+    {
+        return status;
+    }
+    if (length < 1 || reply[0] != count * 2)
+    {
+        return MODBUS_ERROR_FRAME;
+    }
+    for (uint16_t i = 0; i < count; i++)
+    {
+        values[i] = (reply[1 + i * 2] << 8) | reply[2 + i * 2];
+    }
+    return MODBUS_OK;
+}
+
+int modbus_read_registers(ModbusMaster *bus, uint8_t slave, uint8_t function, uint16_t address,
+                          uint16_t count, uint16_t *values)
+{
+    if (count == 0 || count > 125)
+    {
+        return MODBUS_ERROR_FRAME;
+    }
+    uint8_t pdu[4] = {(uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(count >> 8), (uint8_t)count};
+    ModbusRequest request;
+    modbus_request_init(request, slave, function, pdu, sizeof(pdu));
+    return read_registers(bus, request, count, values);
+}
+
+int modbus_read_registers_frame(ModbusMaster *bus, const uint8_t *frame, size_t length, uint16_t *values)
+{
+    ModbusRequest request;
+    if (length != 8 || !modbus_request_init_frame(request, frame, length))
+    {
+        return MODBUS_ERROR_FRAME;
+    }
+    uint16_t count = (frame[4] << 8) | frame[5];
+    if (count == 0 || count > 125)
+    {
+        return MODBUS_ERROR_FRAME;
+    }
+    return read_registers(bus, request, count, values);
+}
+
+void modbus_master_get_stats(ModbusMaster *bus, ModbusStats &out, bool reset)
+{
+    portENTER_CRITICAL(&bus->stats_mux);
+    out = bus->stats;
+    if (reset)
+    {
+        memset(&bus->stats, 0, sizeof(bus->stats));
+    }
+    portEXIT_CRITICAL(&bus->stats_mux);
+}
@@ -0,0 +1,234 @@
+#include "modbus_poller.h"
+#include "modbus_frame.h"
+
+// One block read, on the poller task stack until its callback has run
+typedef struct {
+    uint8_t      first;     // range in order[], inclusive
+    uint8_t      last;
+    uint16_t     start;
+    uint16_t     count;
+    TaskHandle_t waiter;
+} PollBlock;
+
+static ModbusMaster *poll_bus = NULL;
+static const PollPoint *poll_points = NULL;
+static size_t point_count = 0;
+static const uint8_t *const *poll_frames = NULL;
+static size_t poll_frame_count = 0;
+static uint8_t order[POLL_MAX_POINTS];      // point indices sorted by slave, function, address
+static uint32_t next_due[POLL_MAX_POINTS];
+static PollerStats poll_stats;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool same_group(const PollPoint &a, const PollPoint &b)
+{
+    return a.slave == b.slave && a.function == b.function;
+}
+
+static bool sorts_before(const PollPoint &a, const PollPoint &b)
+{
+    if (a.slave != b.slave)
+    {
+        return a.slave < b.slave;
+    }
+    if (a.function != b.function)
+    {
+        return a.function < b.function;
+    }
+    return a.address < b.address;
+}
+
+static bool is_due(size_t index, uint32_t now)
+{
+    return (int32_t)(now - next_due[index]) >= 0;
+}
+
+// Splits the due points into block reads. Points that are not due are only read
+// when they lie between due points of the same block.
+static size_t build_blocks(uint32_t now, PollBlock *blocks)
+{
+    size_t count = 0;
+    size_t i = 0;
+    while (i < point_count)
+    {
+        if (!is_due(order[i], now))
+        {
+            i++;
+            continue;
+        }
+        const PollPoint &head = poll_points[order[i]];
+        size_t last_due = i;
+        uint16_t end = head.address;    // highest address scanned so far
+        for (size_t j = i + 1; j < point_count; j++)
+        {
+            const PollPoint &point = poll_points[order[j]];
+            if (!same_group(head, point) || point.address - end > POLL_MAX_GAP + 1 ||
+                point.address - head.address + 1 > POLL_MAX_BLOCK)
+            {
+                break;
+            }
+            end = point.address;
+            if (is_due(order[j], now))
+            {
+                last_due = j;
+            }
+        }
+
+        PollBlock &block = blocks[count++];
+        block.first = i;
+        block.last = last_due;
+        block.start = head.address;
+        block.count = poll_points[order[last_due]].address - head.address + 1;
+        for (size_t k = i; k <= last_due; k++)
+        {
+            next_due[order[k]] = now + poll_points[order[k]].period_ms;
+        }
+        i = last_due + 1;
+    }
+    return count;
+}
+
+// Prebuilt request for exactly this block, NULL if it has to be built
+static const uint8_t *find_frame(const PollPoint &head, const PollBlock &block)
+{
+    for (size_t i = 0; i < poll_frame_count; i++)
+    {
+        const uint8_t *frame = poll_frames[i];
+        if (frame[0] == head.slave && frame[1] == head.function &&
+            ((frame[2] << 8) | frame[3]) == block.start && ((frame[4] << 8) | frame[5]) == block.count)
+        {
+            return frame;
+        }
+    }
+    return NULL;
+}
+
+static void block_done(const ModbusResult &result, void *ctx)
+{
+    PollBlock *block = (PollBlock *)ctx;
+    uint32_t updated = 0;
+    bool ok = result.status == MODBUS_OK && result.length >= 1 && result.data[0] == block->count * 2;
+    if (ok)
+    {
+        const uint8_t *registers = result.data + 1;
+        for (size_t k = block->first; k <= block->last; k++)
+        {
+            const PollPoint &point = poll_points[order[k]];
+            size_t offset = (point.address - block->start) * 2;
+            uint16_t raw = (registers[offset] << 8) | registers[offset + 1];
+            float value = point.is_signed ? (float)(int16_t)raw : (float)raw;
+            if (point.on_value != NULL)
+            {
+                point.on_value(point, value * point.scale);
+            }
+            updated++;
+        }
+    }
+
+    portENTER_CRITICAL(&stats_mux);
+    poll_stats.transactions++;
+    poll_stats.points_updated += updated;
+    if (!ok)
+    {
+        poll_stats.errors++;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+
+    xTaskNotifyGive(block->waiter);
+}
+
+static void modbus_poller_task(void *pvParameters)
+{
+    PollBlock blocks[POLL_MAX_POINTS];
+    ModbusRequest request;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    while (1)
+    {
+        size_t block_count = build_blocks(millis(), blocks);
+        size_t submitted = 0;
+        for (size_t b = 0; b < block_count; b++)
+        {
+            const PollPoint &head = poll_points[order[blocks[b].first]];
+            const uint8_t *frame = find_frame(head, blocks[b]);
+            if (frame != NULL)
+            {
+                modbus_request_init_frame(request, frame, modbus::request_length);
+            }
+            else
+            {
+                uint8_t pdu[4] = {(uint8_t)(blocks[b].start >> 8), (uint8_t)blocks[b].start,
+                                  (uint8_t)(blocks[b].count >> 8), (uint8_t)blocks[b].count};
+                modbus_request_init(request, head.slave, head.function, pdu, sizeof(pdu));
+            }
+            request.callback = block_done;
+            request.ctx = &blocks[b];
+            blocks[b].waiter = self;
+            if (modbus_master_submit(poll_bus, request, 0))
+            {
+                submitted++;
+            }
+            else
+            {
+                portENTER_CRITICAL(&stats_mux);
+                poll_stats.errors++;
+                portEXIT_CRITICAL(&stats_mux);
+            }
+        }
+
+        // The blocks live on this stack, so wait for every callback
+        size_t completed = 0;
+        while (completed < submitted)
+        {
+            completed += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        if (block_count > 0)
+        {
+            portENTER_CRITICAL(&stats_mux);
+            poll_stats.cycles++;
+            portEXIT_CRITICAL(&stats_mux);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(POLL_TICK_MS));
+    }
+}
+
+bool modbus_poller_begin(ModbusMaster *bus, const PollPoint *points, size_t count,
+                         const uint8_t *const *frames, size_t frame_count)
+{
+    if (bus == NULL || points == NULL || count == 0 || count > POLL_MAX_POINTS || poll_bus != NULL)
+    {
+        return false;
+    }
+    poll_bus = bus;
+    poll_points = points;
+    point_count = count;
+    poll_frames = frames;
+    poll_frame_count = frames != NULL ? frame_count : 0;
+
+    // Insertion sort, the table is small and sorted once
+    uint32_t now = millis();
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t j = i;
+        while (j > 0 && sorts_before(points[i], points[order[j - 1]]))
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+        next_due[i] = now;
+    }
+    return xTaskCreate(modbus_poller_task, "modbus_poller", POLL_TASK_STACK, NULL, POLL_TASK_PRIORITY, NULL) == pdPASS;
+}
+
+void modbus_poller_get_stats(PollerStats &out, bool reset)
+{
+    portENTER_CRITICAL(&stats_mux);
+    out = poll_stats;
+    if (reset)
+    {
+        memset(&poll_stats, 0, sizeof(poll_stats));
+    }
+    portEXIT_CRITICAL(&stats_mux);
+}
@@ -0,0 +1,235 @@
+#include "relay_controller.h"
+#include "modbus_frame.h"
+#include "modbus_gateway.h"
+
+static ModbusMaster *relay_bus = NULL;
+static uint32_t wanted = 0;
+static uint32_t requested = 0;     // relays someone asked for since boot
+static uint32_t shadow = 0;
+static bool shadow_known = false;
+static bool resync_needed = false; // the coils were written by someone else, e.g. through the gateway
+static portMUX_TYPE relay_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Reads all relay coils into shadow.
+static bool read_back()
+{
+    // Constant request, the whole ADU with its CRC is built at compile time
+    static constexpr modbus::Frame<modbus::request_length> frame = modbus::read_coils<RELAY_SLAVE, RELAY_FIRST_COIL, RELAY_COUNT>();
+    ModbusRequest request;
+    modbus_request_init_frame(request, frame, sizeof(frame));
+
+    uint8_t reply[1 + (RELAY_COUNT + 7) / 8];
+    size_t length = 0;
+    if (modbus_master_transact(relay_bus, request, reply, sizeof(reply), &length) != MODBUS_OK ||
+        length != sizeof(reply) || reply[0] != sizeof(reply) - 1)
+    {
+        return false;
+    }
+    uint32_t coils = 0;
+    for (size_t i = 1; i < sizeof(reply); i++)
+    {
+        coils |= (uint32_t)reply[i] << ((i - 1) * 8);
+    }
+    portENTER_CRITICAL(&relay_mux);
+    shadow = coils & RELAY_ALL_MASK;
+    shadow_known = true;
+    portEXIT_CRITICAL(&relay_mux);
+    return true;
+}
+
+// First read of the board: relays nobody asked for keep their current state,
+// so nothing switches at boot.
+static bool adopt_board_state()
+{
+    if (!read_back())
+    {
+        return false;
+    }
+    portENTER_CRITICAL(&relay_mux);
+    wanted = (wanted & requested) | (shadow & ~requested);
+    portEXIT_CRITICAL(&relay_mux);
+    return true;
+}
+
+// Re-read after an outside write: relays with a change that was not written yet keep it,
+// all others take what the board has now, so the next write does not undo the outside one.
+static bool resync_board_state()
+{
+    portENTER_CRITICAL(&relay_mux);
+    uint32_t before = shadow;
+    resync_needed = false;
+    portEXIT_CRITICAL(&relay_mux);
+    if (!read_back())
+    {
+        portENTER_CRITICAL(&relay_mux);
+        resync_needed = true;
+        portEXIT_CRITICAL(&relay_mux);
+        return false;
+    }
+    portENTER_CRITICAL(&relay_mux);
+    uint32_t unwritten = (wanted ^ before) & RELAY_ALL_MASK;
+    wanted = (wanted & unwritten) | (shadow & ~unwritten);
+    portEXIT_CRITICAL(&relay_mux);
+    return true;
+}
+
+// Write-single-coil (0x05) frames for every relay and state, built at compile time
+typedef modbus::MakeCoilWrites<RELAY_SLAVE, RELAY_FIRST_COIL, RELAY_COUNT>::type relay_coil_writes;
+
+// Writes coils first..last (relay numbers) from state: a single relay as its constant
+// 0x05 frame, a span in one 0x0F frame.
+static bool write_coils(uint32_t state, uint8_t first, uint8_t last)
+{
+    ModbusRequest request;
+    if (first == last)
+    {
+        modbus_request_init_frame(request, relay_coil_writes::frames[first][(state >> first) & 1], modbus::request_length);
+    }
+    else
+    {
+        uint16_t address = RELAY_FIRST_COIL + first;
+        uint16_t count = last - first + 1;
+        uint8_t bytes = (count + 7) / 8;
+        uint8_t pdu[5 + (RELAY_COUNT + 7) / 8];
+        pdu[0] = address >> 8;
+        pdu[1] = address;
+        pdu[2] = count >> 8;
+        pdu[3] = count;
+        pdu[4] = bytes;
+        uint32_t bits = (state >> first) & ((1UL << count) - 1);
+        for (uint8_t i = 0; i < bytes; i++)
+        {
+            pdu[5 + i] = bits >> (i * 8);
+        }
+        modbus_request_init(request, RELAY_SLAVE, MODBUS_WRITE_COILS, pdu, 5 + bytes);
+    }
+    bool ok = modbus_master_transact(relay_bus, request) == MODBUS_OK;
+    // Even a failed write may have switched coils, the gateway must not serve the old ones
+    modbus_gateway_invalidate_cache();
+    return ok;
+}
+
+static void relay_controller_task(void *pvParameters)
+{
+    // While the board does not answer, or a write does not stick, the next try waits twice
+    // as long as the last one, so a failing board does not take a bus slot every tick
+    uint32_t retry_interval = RELAY_TICK_MS;
+    uint32_t retry_last = 0;
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(RELAY_TICK_MS));
+        if (millis() - retry_last < retry_interval)
+        {
+            continue;
+        }
+
+        bool ok;
+        const char *failure = NULL;     // logged together with the delay before the next try
+        if (!shadow_known)
+        {
+            ok = adopt_board_state();
+        }
+        else if (resync_needed)
+        {
+            ok = resync_board_state();
+            if (!ok)
+            {
+                failure = "Relay re-read after an outside write failed";
+            }
+        }
+        else
+        {
+            portENTER_CRITICAL(&relay_mux);
+            uint32_t target = wanted;
+            uint32_t changed = (wanted ^ shadow) & RELAY_ALL_MASK;
+            portEXIT_CRITICAL(&relay_mux);
+            if (changed == 0)
+            {
+                continue;
+            }
+
+            // One frame spanning the lowest to the highest changed relay; relays in between
+            // are rewritten with the value they already have
+            uint8_t first = __builtin_ctz(changed);
+            uint8_t last = 31 - __builtin_clz(changed);
+            ok = write_coils(target, first, last);
+            if (!ok)
+            {
+                failure = "Relay write failed";
+            }
+            // A failed read-back leaves the shadow as it was, so the write is repeated
+            else if (!read_back() || ((relay_confirmed_state() ^ target) & changed) != 0)
+            {
+                ok = false;
+                failure = "Relay read-back failed or does not match";
+            }
+        }
+
+        if (ok)
+        {
+            retry_interval = RELAY_TICK_MS;
+        }
+        else
+        {
+            retry_last = millis();
+            retry_interval = (retry_interval * 2 < RELAY_RETRY_MAX_MS) ? retry_interval * 2 : RELAY_RETRY_MAX_MS;
+            if (failure != NULL)
+            {
+                Serial.printf("%s, retrying in %u ms\n", failure, (unsigned)retry_interval);
+            }
+        }
+    }
+}
+
+bool relay_controller_begin(ModbusMaster *bus)
+{
+    if (bus == NULL || relay_bus != NULL)
+    {
+        return false;
+    }
+    relay_bus = bus;
+    adopt_board_state();
+    return xTaskCreate(relay_controller_task, "relay_ctrl", RELAY_TASK_STACK, NULL, RELAY_TASK_PRIORITY, NULL) == pdPASS;
+}
+
+bool relay_set(uint8_t relay, bool on)
+{
+    if (relay >= RELAY_COUNT)
+    {
+        return false;
+    }
+    relay_set_mask(1UL << relay, on ? 1UL << relay : 0);
+    return true;
+}
+
+void relay_set_mask(uint32_t mask, uint32_t values)
+{
+    portENTER_CRITICAL(&relay_mux);
+    wanted = (wanted & ~mask) | (values & mask & RELAY_ALL_MASK);
+    requested |= mask;
+    portEXIT_CRITICAL(&relay_mux);
+}
+
+bool relay_get(uint8_t relay)
+{
+    return relay < RELAY_COUNT && (wanted >> relay) & 1;
+}
+
+void relay_controller_invalidate()
+{
+    portENTER_CRITICAL(&relay_mux);
+    resync_needed = true;
+    portEXIT_CRITICAL(&relay_mux);
+}
+
+uint32_t relay_confirmed_state(bool *known)
+{
+    portENTER_CRITICAL(&relay_mux);
+    uint32_t state = shadow;
+    if (known != NULL)
+    {
+        *known = shadow_known;
+    }
+    portEXIT_CRITICAL(&relay_mux);
+    return state;
+}
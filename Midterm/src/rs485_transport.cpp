@@ -0,0 +1,147 @@
+#include "rs485_transport.h"
+
+typedef struct {
+    uint8_t data[MODBUS_MAX_ADU];   // first, release() gets this pointer back
+    size_t  length;
+} FrameBuffer;
+
+static bool started = false;
+static uart_port_t uart_port;
+static QueueHandle_t uart_events = NULL;
+static QueueHandle_t free_frames = NULL;
+static FrameBuffer frame_pool[RS485_FRAME_POOL];
+static ModbusTransport transport;
+
+static bool rs485_send(void *ctx, const uint8_t *frame, size_t length)
+{
+    // Whatever arrived since the last exchange (a late reply, line noise) is stale now
+    uart_flush_input(uart_port);
+    xQueueReset(uart_events);
+    if (uart_write_bytes(uart_port, frame, length) != (int)length)
+    {
+        return false;
+    }
+    // Returns when the last stop bit is out; in half-duplex mode DE drops with it
+    return uart_wait_tx_done(uart_port, pdMS_TO_TICKS(RS485_TX_TIMEOUT_MS)) == ESP_OK;
+}
+
+static const uint8_t *rs485_receive(void *ctx, size_t *length, uint32_t timeout_ms)
+{
+    FrameBuffer *buffer;
+    if (xQueueReceive(free_frames, &buffer, 0) != pdTRUE)
+    {
+        return NULL;
+    }
+    buffer->length = 0;
+    bool damaged = false;
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+
+    while (true)
+    {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+        uart_event_t event;
+        if (xQueueReceive(uart_events, &event, wait) != pdTRUE)
+        {
+            break;
+        }
+        switch (event.type)
+        {
+        case UART_DATA:
+        {
+            size_t room = sizeof(buffer->data) - buffer->length;
+            if (event.size > room)
+            {
+                damaged = true;
+            }
+            int read = uart_read_bytes(uart_port, buffer->data + buffer->length, event.size < room ? event.size : room, 0);
+            if (read > 0)
+            {
+                buffer->length += read;
+            }
+            if (event.timeout_flag)
+            {
+                // End of frame
+                if (!damaged && buffer->length > 0)
+                {
+                    *length = buffer->length;
+                    return buffer->data;
+                }
+                buffer->length = 0;
+                damaged = false;
+            }
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            uart_flush_input(uart_port);
+            xQueueReset(uart_events);
+            buffer->length = 0;
+            damaged = false;
+            break;
+        case UART_FRAME_ERR:
+        case UART_PARITY_ERR:
+        case UART_BREAK:
+            damaged = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    xQueueSend(free_frames, &buffer, 0);
+    return NULL;
+}
+
+static void rs485_release(void *ctx, const uint8_t *frame)
+{
+    FrameBuffer *buffer = (FrameBuffer *)frame;
+    xQueueSend(free_frames, &buffer, 0);
+}
+
+const ModbusTransport *rs485_transport_begin(uart_port_t port, uint32_t baud, int rx_pin, int tx_pin, int de_pin)
+{
+    if (started)
+    {
+        return &transport;
+    }
+    uart_config_t config = {};
+    config.baud_rate = baud;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+
+    if (uart_driver_install(port, RS485_RX_BUFFER, 0, RS485_EVENT_QUEUE, &uart_events, 0) != ESP_OK)
+    {
+        return NULL;
+    }
+    if (uart_param_config(port, &config) != ESP_OK ||
+        uart_set_pin(port, tx_pin, rx_pin, de_pin >= 0 ? de_pin : UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK ||
+        uart_set_mode(port, de_pin >= 0 ? UART_MODE_RS485_HALF_DUPLEX : UART_MODE_UART) != ESP_OK ||
+        uart_set_rx_timeout(port, RS485_FRAME_GAP_SYMBOLS) != ESP_OK)
+    {
+        uart_driver_delete(port);
+        return NULL;
+    }
+
+    free_frames = xQueueCreate(RS485_FRAME_POOL, sizeof(FrameBuffer *));
+    if (free_frames == NULL)
+    {
+        uart_driver_delete(port);
+        return NULL;
+    }
+    for (int i = 0; i < RS485_FRAME_POOL; i++)
+    {
+        FrameBuffer *buffer = &frame_pool[i];
+        xQueueSend(free_frames, &buffer, 0);
+    }
+
+    uart_port = port;
+    started = true;
+    transport.ctx = NULL;
+    transport.send = rs485_send;
+    transport.receive = rs485_receive;
+    transport.release = rs485_release;
+    return &transport;
+}
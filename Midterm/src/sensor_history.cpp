@@ -0,0 +1,176 @@
+#include "sensor_history.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+// Overwrite-oldest ring over a static array
+template <typename T, size_t N>
+struct HistoryRing
+{
+    T items[N];
+    size_t head;    // next write position
+    size_t count;
+
+    void push(const T &item)
+    {
+        items[head] = item;
+        head = (head + 1) % N;
+        if (count < N)
+        {
+            count++;
+        }
+    }
+
+    // i = 0 is the oldest stored element
+    const T &at(size_t i) const
+    {
+        return items[(head + N - count + i) % N];
+    }
+
+    size_t copy_latest(T *out, size_t max_count) const
+    {
+        size_t n = (max_count < count) ? max_count : count;
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = at(count - n + i);
+        }
+        return n;
+    }
+};
+
+// Open bucket that is folded into a rollup once its period ends
+typedef struct {
+    uint32_t bucket;
+    float    min;
+    float    max;
+    float    sum;
+    uint16_t count;
+} RollupAccumulator;
+
+typedef struct {
+    HistoryRing<SensorSample, HISTORY_RAW_SAMPLES> raw;
+    HistoryRing<SensorRollup, HISTORY_MINUTE_ROLLUPS> minute;
+    HistoryRing<SensorRollup, HISTORY_QUARTER_ROLLUPS> quarter;
+    RollupAccumulator open[HISTORY_RESOLUTION_COUNT];
+} ChannelHistory;
+
+static const uint32_t resolution_seconds[HISTORY_RESOLUTION_COUNT] = {60, 900};
+static const char *channel_names[SENSOR_CHANNEL_COUNT] = {"temperature", "humidity", "sound", "pressure"};
+
+static ChannelHistory history[SENSOR_CHANNEL_COUNT];
+static portMUX_TYPE history_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void close_bucket(ChannelHistory &ch, HistoryResolution resolution)
+{
+    RollupAccumulator &acc = ch.open[resolution];
+    if (acc.count == 0)
+    {
+        return;
+    }
+
+    SensorRollup rollup;
+    rollup.start_s = acc.bucket * resolution_seconds[resolution];
+    rollup.min = acc.min;
+    rollup.max = acc.max;
+    rollup.avg = acc.sum / acc.count;
+    rollup.count = acc.count;
+
+    if (resolution == HISTORY_1_MIN)
+    {
+        ch.minute.push(rollup);
+    }
+    else
+    {
+        ch.quarter.push(rollup);
+    }
+    acc.count = 0;
+}
+
+static void accumulate(ChannelHistory &ch, HistoryResolution resolution, uint32_t now_s, float value)
+{
+    RollupAccumulator &acc = ch.open[resolution];
+    uint32_t bucket = now_s / resolution_seconds[resolution];
+
+    if (acc.count > 0 && acc.bucket != bucket)
+    {
+        close_bucket(ch, resolution);
+    }
+
+    if (acc.count == 0)
+    {
+        acc.bucket = bucket;
+        acc.min = acc.max = value;
+        acc.sum = 0;
+    }
+    acc.min = (value < acc.min) ? value : acc.min;
+    acc.max = (value > acc.max) ? value : acc.max;
+    acc.sum += value;
+    acc.count++;
+}
+
+void sensor_history_record(SensorChannel channel, float value, int64_t timestamp_us)
+{
+    if (channel >= SENSOR_CHANNEL_COUNT || isnan(value))
+    {
+        return;
+    }
+    if (timestamp_us == 0)
+    {
+        timestamp_us = esp_timer_get_time();
+    }
+    uint32_t now_s = (uint32_t)(timestamp_us / 1000000);
+
+    ChannelHistory &ch = history[channel];
+    SensorSample sample = {timestamp_us, value};
+
+    portENTER_CRITICAL(&history_mux);
+    ch.raw.push(sample);
+    accumulate(ch, HISTORY_1_MIN, now_s, value);
+    accumulate(ch, HISTORY_15_MIN, now_s, value);
+    portEXIT_CRITICAL(&history_mux);
+}
+
+size_t sensor_history_raw(SensorChannel channel, SensorSample *out, size_t max_count)
+{
+    if (channel >= SENSOR_CHANNEL_COUNT || out == NULL)
+    {
+        return 0;
+    }
+    portENTER_CRITICAL(&history_mux);
+    size_t n = history[channel].raw.copy_latest(out, max_count);
+    portEXIT_CRITICAL(&history_mux);
+    return n;
+}
+
+size_t sensor_history_rollups(SensorChannel channel, HistoryResolution resolution, SensorRollup *out, size_t max_count)
+{
+    if (channel >= SENSOR_CHANNEL_COUNT || resolution >= HISTORY_RESOLUTION_COUNT || out == NULL)
+    {
+        return 0;
+    }
+    size_t n;
+    portENTER_CRITICAL(&history_mux);
+    if (resolution == HISTORY_1_MIN)
+    {
+        n = history[channel].minute.copy_latest(out, max_count);
+    }
+    else
+    {
+        n = history[channel].quarter.copy_latest(out, max_count);
+    }
+    portEXIT_CRITICAL(&history_mux);
+    return n;
+}
+
+bool sensor_history_latest(SensorChannel channel, SensorSample &out)
+{
+    return sensor_history_raw(channel, &out, 1) == 1;
+}
+
+const char *sensor_history_channel_name(SensorChannel channel)
+{
+    if (channel >= SENSOR_CHANNEL_COUNT)
+    {
+        return "unknown";
+    }
+    return channel_names[channel];
+}
@@ -0,0 +1,73 @@
+#include "sensor_snapshot.h"
+#include <atomic>
+#include "esp_timer.h"
+
+#define SNAPSHOT_READ_RETRIES 8
+
+// Seqlock: the counter is odd while the writer is inside the update,
+// and every completed publish advances it by 2.
+static std::atomic<uint32_t> snapshot_seq(0);
+static SensorSnapshot snapshot_slot = {0.0f, 0.0f, 0, 0, false};
+
+void sensor_snapshot_publish(float temperature, float humidity, bool valid)
+{
+    uint32_t seq = snapshot_seq.load(std::memory_order_relaxed);
+
+    snapshot_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    snapshot_slot.temperature = temperature;
+    snapshot_slot.humidity = humidity;
+    snapshot_slot.sequence = (seq + 2) / 2;
+    snapshot_slot.timestamp_us = esp_timer_get_time();
+    snapshot_slot.valid = valid;
+
+    snapshot_seq.store(seq + 2, std::memory_order_release);
+}
+
+bool sensor_snapshot_read(SensorSnapshot &out)
+{
+    for (int i = 0; i < SNAPSHOT_READ_RETRIES; i++)
+    {
+        uint32_t before = snapshot_seq.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            // Writer is mid-update, let it finish instead of spinning on it
+            taskYIELD();
+            continue;
+        }
+
+        SensorSnapshot copy = snapshot_slot;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t after = snapshot_seq.load(std::memory_order_relaxed);
+        if (before == after)
+        {
+            out = copy;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t sensor_snapshot_sequence()
+{
+    return snapshot_seq.load(std::memory_order_acquire) / 2;
+}
+
+bool sensor_snapshot_read_newer(uint32_t &last_sequence, SensorSnapshot &out)
+{
+    if (sensor_snapshot_sequence() == last_sequence)
+    {
+        return false;
+    }
+    SensorSnapshot copy;
+    if (!sensor_snapshot_read(copy))
+    {
+        // Writer kept us out; last_sequence stays put so the sample is picked up next time
+        return false;
+    }
+    last_sequence = copy.sequence;
+    out = copy;
+    return true;
+}
@@ -2,10 +2,12 @@
 #include "task_core_iot.h"
 
 constexpr uint32_t MAX_MESSAGE_SIZE = 1024U;
+// Room for the nested per-key objects of the telemetryPolicy shared attribute
+constexpr size_t MAX_FIELDS_AMOUNT = 32U;
 
 WiFiClient wifiClient;
 Arduino_MQTT_Client mqttClient(wifiClient);
-ThingsBoard tb(mqttClient, MAX_MESSAGE_SIZE);
+ThingsBoardSized<MAX_FIELDS_AMOUNT> tb(mqttClient, MAX_MESSAGE_SIZE);
 
 constexpr char LED_STATE_ATTR[] = "ledState";
 
@@ -17,15 +19,45 @@ constexpr uint16_t BLINKING_INTERVAL_MS_MAX = 60000U;
 volatile uint16_t blinkingInterval = 1000U;
 
 constexpr int16_t telemetrySendInterval = 10000U;
+constexpr size_t TELEMETRY_BATCH_SAMPLES = 16U;
+
+// Batches go out with QoS 1, so the client resends them until the broker acknowledges them.
+constexpr uint8_t TELEMETRY_BATCH_QOS = 1U;
+
+// RS485 slaves are ThingsBoard sub-devices of this board, all of them are sent with one gateway publish per cycle
+constexpr char RS485_SENSOR_DEVICE[] = "RS485 sensor 6";
+constexpr char RS485_RELAY_DEVICE[] = "RS485 relay 1";
+constexpr char RS485_DEVICE_TYPE[] = "rs485";
+constexpr uint32_t GATEWAY_CYCLE_MS = 5000U;
+// Raw samples per channel looked at each cycle, ~5 new ones arrive at the 1 s poll rate
+constexpr size_t GATEWAY_SAMPLES_PER_CYCLE = 16U;
+
+struct GatewayKey
+{
+    const char *key;
+    SensorChannel channel;
+};
+
+constexpr GatewayKey RS485_SENSOR_KEYS[] = {
+    {"sound", SENSOR_SOUND},
+    {"pressure", SENSOR_PRESSURE},
+};
 
 constexpr std::array<const char *, 2U> SHARED_ATTRIBUTES_LIST = {
     LED_STATE_ATTR,
+    FILTER_POLICY_ATTR,
 };
 
 void processSharedAttributes(const Shared_Attribute_Data &data)
 {
     for (auto it = data.begin(); it != data.end(); ++it)
     {
+        if (strcmp(it->key().c_str(), FILTER_POLICY_ATTR) == 0)
+        {
+            size_t updated = telemetry_filter_apply_attribute(it->value());
+            Serial.print("Telemetry policy updated for keys: ");
+            Serial.println(updated);
+        }
         // if (strcmp(it->key().c_str(), BLINKING_INTERVAL_ATTR) == 0)
         // {
         //     const uint16_t new_interval = it->value().as<uint16_t>();
@@ -56,8 +88,25 @@ RPC_Response setLedSwitchValue(const RPC_Data &data)
     return RPC_Response("setLedSwitchValue", newState);
 }
 
-const std::array<RPC_Callback, 1U> callbacks = {
-    RPC_Callback{"setLedSwitchValue", setLedSwitchValue}};
+// {"relay": 0..3, "state": true}; without "relay" all relays switch
+RPC_Response setRelay(const RPC_Data &data)
+{
+    int relay = data["relay"] | -1;
+    bool on = data["state"] | false;
+    if (relay < 0)
+    {
+        relay_set_mask(RELAY_ALL_MASK, on ? RELAY_ALL_MASK : 0);
+    }
+    else if (!relay_set(relay, on))
+    {
+        return RPC_Response("setRelay", "invalid relay");
+    }
+    return RPC_Response("setRelay", on);
+}
+
+const std::array<RPC_Callback, 2U> callbacks = {
+    RPC_Callback{"setLedSwitchValue", setLedSwitchValue},
+    RPC_Callback{"setRelay", setRelay}};
 
 const Shared_Attribute_Callback attributes_callback(&processSharedAttributes, SHARED_ATTRIBUTES_LIST.cbegin(), SHARED_ATTRIBUTES_LIST.cend());
 const Attribute_Request_Callback attribute_shared_request_callback(&processSharedAttributes, SHARED_ATTRIBUTES_LIST.cbegin(), SHARED_ATTRIBUTES_LIST.cend());
@@ -71,7 +120,20 @@ void CORE_IOT_sendata(String mode, String feed, String data)
     else if (mode == "telemetry")
     {
         float value = data.toFloat();
-        tb.sendTelemetryData(feed.c_str(), value);
+        if (!telemetry_filter_should_report(feed.c_str(), value))
+        {
+            return;
+        }
+        const uint64_t ts = epoch_ms();
+        if (ts == 0)
+        {
+            // Without a real timestamp samples cannot share a batch, the server time of arrival is used
+            tb.sendTelemetryData(feed.c_str(), value);
+        }
+        else
+        {
+            tb.sendTelemetryDataBatched(feed.c_str(), value, ts);
+        }
     }
     else
     {
@@ -79,6 +141,72 @@ void CORE_IOT_sendata(String mode, String feed, String data)
     }
 }
 
+// Unix time in ms of a sample taken at the given esp_timer time, 0 before SNTP has synced
+static uint64_t sampleTimestamp(uint64_t now_ms, int64_t timestamp_us)
+{
+    if (now_ms == 0)
+    {
+        return 0;
+    }
+    return now_ms - (esp_timer_get_time() - timestamp_us) / 1000;
+}
+
+static void CORE_IOT_send_gateway()
+{
+    static uint32_t lastCycle = 0;
+    static int64_t sentSample[SENSOR_CHANNEL_COUNT] = {};
+    static bool relaysSent = false;
+    static uint32_t sentRelays = 0;
+    if (millis() - lastCycle < GATEWAY_CYCLE_MS)
+    {
+        return;
+    }
+    lastCycle = millis();
+    const uint64_t now = epoch_ms();
+
+    // Every reading the poller delivered since the last cycle, each with the time it was taken at
+    SensorSample samples[GATEWAY_SAMPLES_PER_CYCLE];
+    for (const GatewayKey &entry : RS485_SENSOR_KEYS)
+    {
+        const size_t count = sensor_history_raw(entry.channel, samples, GATEWAY_SAMPLES_PER_CYCLE);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (samples[i].timestamp_us <= sentSample[entry.channel])
+            {
+                continue;
+            }
+            const Telemetry value(entry.key, samples[i].value);
+            if (!tb.sendGatewayTelemetry(RS485_SENSOR_DEVICE, &value, 1U, sampleTimestamp(now, samples[i].timestamp_us)))
+            {
+                // Retried from this sample on the next cycle
+                break;
+            }
+            sentSample[entry.channel] = samples[i].timestamp_us;
+        }
+    }
+
+    bool known = false;
+    const uint32_t relays = relay_confirmed_state(&known);
+    if (known && (!relaysSent || relays != sentRelays))
+    {
+        relaysSent = true;
+        sentRelays = relays;
+        const Telemetry state("relays", relays);
+        tb.sendGatewayTelemetry(RS485_RELAY_DEVICE, &state, 1U, now);
+    }
+    tb.flushGatewayTelemetry();
+}
+
+void CORE_IOT_setup()
+{
+    // Samples are collected and sent together, at the latest one send interval after the first one.
+    // The batch memory is allocated once here and survives reconnects.
+    if (!tb.setTelemetryBatching(TELEMETRY_BATCH_SAMPLES, telemetrySendInterval, 0U, TELEMETRY_BATCH_QOS))
+    {
+        Serial.println("Failed to enable telemetry batching");
+    }
+}
+
 void CORE_IOT_reconnect()
 {
     if (!tb.connected())
@@ -91,6 +219,10 @@ void CORE_IOT_reconnect()
 
         tb.sendAttributeData("macAddress", WiFi.macAddress().c_str());
 
+        // Announced again by the library after every reconnect
+        tb.Gateway_Connect_Device(RS485_SENSOR_DEVICE, RS485_DEVICE_TYPE);
+        tb.Gateway_Connect_Device(RS485_RELAY_DEVICE, RS485_DEVICE_TYPE);
+
         Serial.println("Subscribing for RPC...");
         if (!tb.RPC_Subscribe(callbacks.cbegin(), callbacks.cend()))
         {
@@ -115,6 +247,7 @@ void CORE_IOT_reconnect()
     }
     else if (tb.connected())
     {
+        CORE_IOT_send_gateway();
         tb.loop();
     }
 }
\ No newline at end of file
@@ -1,19 +1,18 @@
 #include <task_handler.h>
 
-void handleWebSocketMessage(String message)
+static void dispatchWebSocketMessage(JsonDocument &doc)
 {
-    Serial.println(message);
-    StaticJsonDocument<256> doc;
-
-    DeserializationError error = deserializeJson(doc, message);
-    if (error)
-    {
-        Serial.println("❌ Lỗi parse JSON!");
-        return;
-    }
     JsonObject value = doc["value"];
     if (doc["page"] == "device")
     {
+        // {"page":"device","value":{"relay":2,"status":"ON"}} goes to the RS485 relay board
+        if (value.containsKey("relay"))
+        {
+            String status = value["status"].as<String>();
+            relay_set(value["relay"].as<int>(), status.equalsIgnoreCase("ON"));
+            Serial.printf("⚙️ Relay %d → %s\n", value["relay"].as<int>(), status.c_str());
+            return;
+        }
         if (!value.containsKey("gpio") || !value.containsKey("status"))
         {
             Serial.println("⚠️ JSON thiếu thông tin gpio hoặc status");
@@ -59,3 +58,28 @@ void handleWebSocketMessage(String message)
         ws.textAll(msg);
     }
 }
+
+void handleWebSocketMessage(uint8_t *data, size_t len)
+{
+    Serial.write(data, len);
+    Serial.println();
+
+    JsonDocument *doc = json_arena_acquire();
+    if (doc == NULL)
+    {
+        Serial.println("⚠️ Không còn JSON arena trống, bỏ qua tin nhắn");
+        return;
+    }
+
+    // The frame buffer is writeable, so strings are parsed in place instead of being copied
+    DeserializationError error = deserializeJson(*doc, data, len);
+    if (error)
+    {
+        Serial.println("❌ Lỗi parse JSON!");
+    }
+    else
+    {
+        dispatchWebSocketMessage(*doc);
+    }
+    json_arena_release(doc);
+}
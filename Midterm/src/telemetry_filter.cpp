@@ -0,0 +1,148 @@
+#include "telemetry_filter.h"
+#include "freertos/FreeRTOS.h"
+
+typedef struct {
+    char         key[FILTER_KEY_LENGTH];
+    ReportPolicy policy;
+    float        last_value;
+    uint32_t     last_report_ms;
+    bool         reported;
+} FilterEntry;
+
+static const ReportPolicy default_policy = {0.0f, 0.0f, 0, FILTER_DEFAULT_HEARTBEAT_MS};
+
+static FilterEntry entries[FILTER_MAX_KEYS];
+static size_t entry_count = 0;
+static portMUX_TYPE filter_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Caller holds filter_mux. Returns NULL if the key is too long or the table is full.
+static FilterEntry *find_or_add(const char *key)
+{
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        if (strcmp(entries[i].key, key) == 0)
+        {
+            return &entries[i];
+        }
+    }
+    if (entry_count >= FILTER_MAX_KEYS || strlen(key) >= FILTER_KEY_LENGTH)
+    {
+        return NULL;
+    }
+    FilterEntry &entry = entries[entry_count++];
+    strcpy(entry.key, key);
+    entry.policy = default_policy;
+    entry.reported = false;
+    return &entry;
+}
+
+bool telemetry_filter_set_policy(const char *key, const ReportPolicy &policy)
+{
+    if (key == NULL)
+    {
+        return false;
+    }
+    portENTER_CRITICAL(&filter_mux);
+    FilterEntry *entry = find_or_add(key);
+    if (entry != NULL)
+    {
+        entry->policy = policy;
+    }
+    portEXIT_CRITICAL(&filter_mux);
+    return entry != NULL;
+}
+
+bool telemetry_filter_should_report(const char *key, float value)
+{
+    if (key == NULL || isnan(value))
+    {
+        return false;
+    }
+    uint32_t now = millis();
+    bool report;
+
+    portENTER_CRITICAL(&filter_mux);
+    FilterEntry *entry = find_or_add(key);
+    if (entry == NULL)
+    {
+        // No room to track this key, fall back to reporting everything
+        report = true;
+    }
+    else if (!entry->reported)
+    {
+        report = true;
+    }
+    else
+    {
+        const ReportPolicy &policy = entry->policy;
+        uint32_t elapsed = now - entry->last_report_ms;
+        float delta = fabsf(value - entry->last_value);
+
+        if (elapsed < policy.min_interval_ms)
+        {
+            report = false;
+        }
+        else if (policy.heartbeat_ms != 0 && elapsed >= policy.heartbeat_ms)
+        {
+            report = true;
+        }
+        else if (policy.abs_deadband <= 0.0f && policy.rel_deadband <= 0.0f)
+        {
+            report = delta != 0.0f;
+        }
+        else
+        {
+            report = (policy.abs_deadband > 0.0f && delta >= policy.abs_deadband) ||
+                     (policy.rel_deadband > 0.0f && delta >= policy.rel_deadband * fabsf(entry->last_value));
+        }
+    }
+
+    if (report && entry != NULL)
+    {
+        entry->last_value = value;
+        entry->last_report_ms = now;
+        entry->reported = true;
+    }
+    portEXIT_CRITICAL(&filter_mux);
+    return report;
+}
+
+size_t telemetry_filter_apply_attribute(JsonVariantConst policies)
+{
+    // The policy may arrive as a JSON object or as a string holding the JSON
+    StaticJsonDocument<1024> doc;
+    if (policies.is<const char *>())
+    {
+        if (deserializeJson(doc, policies.as<const char *>()))
+        {
+            Serial.println("telemetryPolicy: invalid JSON");
+            return 0;
+        }
+        policies = doc.as<JsonVariantConst>();
+    }
+    if (!policies.is<JsonObjectConst>())
+    {
+        return 0;
+    }
+
+    size_t updated = 0;
+    for (JsonPairConst kv : policies.as<JsonObjectConst>())
+    {
+        JsonObjectConst settings = kv.value().as<JsonObjectConst>();
+        if (settings.isNull())
+        {
+            continue;
+        }
+        ReportPolicy policy;
+        policy.abs_deadband = settings["deadband"] | 0.0f;
+        policy.rel_deadband = settings["relative"] | 0.0f;
+        policy.min_interval_ms = (settings["minInterval"] | 0UL) * 1000UL;
+        policy.heartbeat_ms = (settings["heartbeat"] | (FILTER_DEFAULT_HEARTBEAT_MS / 1000UL)) * 1000UL;
+
+        if (telemetry_filter_set_policy(kv.key().c_str(), policy))
+        {
+            updated++;
+        }
+    }
+    return updated;
+}
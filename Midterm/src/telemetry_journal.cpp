@@ -0,0 +1,354 @@
+#include "telemetry_journal.h"
+
+#define JOURNAL_MAGIC       0x4A54      // "TJ"
+#define JOURNAL_CURSOR_FILE JOURNAL_DIR "/cursor"
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint16_t length;
+    uint32_t crc;
+} JournalHeader;
+
+typedef struct {
+    uint32_t segment;
+    uint32_t offset;
+} JournalCursor;
+
+// Only coreiot_task appends and drains, so the state needs no locking.
+// While the journal is empty first_seg is the id the next segment will get.
+static bool journal_ready = false;
+static bool have_segments = false;
+static uint32_t first_seg = 0;
+static uint32_t last_seg = 0;
+static uint32_t read_offset = 0;    // within first_seg
+static uint32_t last_size = 0;      // bytes in last_seg
+static uint32_t dropped_records = 0;
+static uint32_t last_drain_ms = 0;
+static char batch[JOURNAL_BATCH_BYTES];
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    crc = ~crc;
+    while (length--)
+    {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static void segment_path(uint32_t segment, char *path, size_t size)
+{
+    snprintf(path, size, JOURNAL_DIR "/%08lu.seg", (unsigned long)segment);
+}
+
+static void save_cursor()
+{
+    JournalCursor cursor = {first_seg, read_offset};
+    File file = LittleFS.open(JOURNAL_CURSOR_FILE, FILE_WRITE);
+    if (!file)
+    {
+        return;
+    }
+    file.write((const uint8_t *)&cursor, sizeof(cursor));
+    file.close();
+}
+
+// Reads the next frame at the current file position. Returns false at end of
+// data or on a damaged frame; values is NUL terminated on success.
+static bool read_record(File &file, int64_t &ts_ms, char *values)
+{
+    JournalHeader header;
+    if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header))
+    {
+        return false;
+    }
+    if (header.magic != JOURNAL_MAGIC || header.length == 0 || header.length > JOURNAL_MAX_RECORD)
+    {
+        return false;
+    }
+    if (file.read((uint8_t *)&ts_ms, sizeof(ts_ms)) != sizeof(ts_ms) ||
+        file.read((uint8_t *)values, header.length) != header.length)
+    {
+        return false;
+    }
+    uint32_t crc = crc32_update(0, (const uint8_t *)&ts_ms, sizeof(ts_ms));
+    crc = crc32_update(crc, (const uint8_t *)values, header.length);
+    if (crc != header.crc)
+    {
+        return false;
+    }
+    values[header.length] = '\0';
+    return true;
+}
+
+// Removes the oldest segment, after it was either sent or evicted.
+static void retire_first_segment()
+{
+    char path[32];
+    segment_path(first_seg, path, sizeof(path));
+    LittleFS.remove(path);
+
+    if (first_seg == last_seg)
+    {
+        have_segments = false;
+        last_size = 0;
+    }
+    first_seg++;
+    read_offset = 0;
+}
+
+static void evict_oldest_segment()
+{
+    char path[32];
+    char values[JOURNAL_MAX_RECORD + 1];
+    int64_t ts_ms;
+    uint32_t lost = 0;
+
+    segment_path(first_seg, path, sizeof(path));
+    File file = LittleFS.open(path, FILE_READ);
+    if (file)
+    {
+        file.seek(read_offset);
+        while (read_record(file, ts_ms, values))
+        {
+            lost++;
+        }
+        file.close();
+    }
+    dropped_records += lost;
+    Serial.printf("Journal full, dropped %lu oldest records\n", (unsigned long)lost);
+
+    retire_first_segment();
+    save_cursor();
+}
+
+bool telemetry_journal_begin()
+{
+    if (!LittleFS.begin(true))
+    {
+        Serial.println("Journal: LittleFS mount failed");
+        return false;
+    }
+    if (!LittleFS.exists(JOURNAL_DIR))
+    {
+        LittleFS.mkdir(JOURNAL_DIR);
+    }
+
+    JournalCursor cursor = {0, 0};
+    File file = LittleFS.open(JOURNAL_CURSOR_FILE, FILE_READ);
+    if (file)
+    {
+        if (file.read((uint8_t *)&cursor, sizeof(cursor)) != sizeof(cursor))
+        {
+            cursor.segment = 0;
+            cursor.offset = 0;
+        }
+        file.close();
+    }
+
+    // Recover the segment range from the file names
+    have_segments = false;
+    File dir = LittleFS.open(JOURNAL_DIR);
+    File entry = dir.openNextFile();
+    while (entry)
+    {
+        const char *name = strrchr(entry.name(), '/');
+        name = name ? name + 1 : entry.name();
+        if (strstr(name, ".seg") != NULL)
+        {
+            uint32_t segment = strtoul(name, NULL, 10);
+            if (!have_segments || segment < first_seg)
+            {
+                first_seg = segment;
+            }
+            if (!have_segments || segment > last_seg)
+            {
+                last_seg = segment;
+            }
+            have_segments = true;
+        }
+        entry.close();
+        entry = dir.openNextFile();
+    }
+    dir.close();
+
+    if (!have_segments)
+    {
+        first_seg = cursor.segment;
+        read_offset = 0;
+    }
+    else
+    {
+        // Segments before the cursor were sent but not yet removed when we went down
+        while (have_segments && first_seg < cursor.segment)
+        {
+            retire_first_segment();
+        }
+        read_offset = (have_segments && first_seg == cursor.segment) ? cursor.offset : 0;
+        if (have_segments)
+        {
+            char path[32];
+            segment_path(last_seg, path, sizeof(path));
+            File last = LittleFS.open(path, FILE_READ);
+            last_size = last ? last.size() : 0;
+            last.close();
+        }
+        else
+        {
+            first_seg = cursor.segment;
+        }
+    }
+
+    journal_ready = true;
+    return true;
+}
+
+bool telemetry_journal_append(int64_t ts_ms, const char *values_json)
+{
+    if (!journal_ready || values_json == NULL)
+    {
+        return false;
+    }
+    size_t length = strlen(values_json);
+    if (length == 0 || length > JOURNAL_MAX_RECORD)
+    {
+        return false;
+    }
+    size_t frame = sizeof(JournalHeader) + sizeof(ts_ms) + length;
+
+    if (!have_segments)
+    {
+        last_seg = first_seg;
+        last_size = 0;
+        read_offset = 0;
+        have_segments = true;
+    }
+    else if (last_size + frame > JOURNAL_SEGMENT_BYTES)
+    {
+        last_seg++;
+        last_size = 0;
+        if (last_seg - first_seg + 1 > JOURNAL_MAX_SEGMENTS)
+        {
+            evict_oldest_segment();
+        }
+    }
+
+    JournalHeader header;
+    header.magic = JOURNAL_MAGIC;
+    header.length = (uint16_t)length;
+    header.crc = crc32_update(0, (const uint8_t *)&ts_ms, sizeof(ts_ms));
+    header.crc = crc32_update(header.crc, (const uint8_t *)values_json, length);
+
+    char path[32];
+    segment_path(last_seg, path, sizeof(path));
+    File file = LittleFS.open(path, FILE_APPEND);
+    if (!file)
+    {
+        return false;
+    }
+    size_t written = file.write((const uint8_t *)&header, sizeof(header));
+    written += file.write((const uint8_t *)&ts_ms, sizeof(ts_ms));
+    written += file.write((const uint8_t *)values_json, length);
+    file.close();
+
+    if (written != frame)
+    {
+        // The reader skips a torn frame together with the rest of its segment,
+        // so start the next record in a fresh one
+        last_size = JOURNAL_SEGMENT_BYTES;
+        return false;
+    }
+    last_size += written;
+    return true;
+}
+
+size_t telemetry_journal_drain(JournalPublishFn publish)
+{
+    if (!journal_ready || !have_segments || publish == NULL)
+    {
+        return 0;
+    }
+    uint32_t now = millis();
+    if (now - last_drain_ms < JOURNAL_DRAIN_INTERVAL_MS)
+    {
+        return 0;
+    }
+    last_drain_ms = now;
+
+    char path[32];
+    segment_path(first_seg, path, sizeof(path));
+    File file = LittleFS.open(path, FILE_READ);
+    if (!file)
+    {
+        retire_first_segment();
+        save_cursor();
+        return 0;
+    }
+    file.seek(read_offset);
+
+    char values[JOURNAL_MAX_RECORD + 1];
+    int64_t ts_ms;
+    size_t used = 0;
+    size_t count = 0;
+    uint32_t offset = read_offset;
+    bool segment_done = false;
+
+    batch[used++] = '[';
+    while (true)
+    {
+        if (!read_record(file, ts_ms, values))
+        {
+            // End of data, or a damaged frame: nothing after it can be trusted
+            segment_done = true;
+            break;
+        }
+        int n;
+        if (ts_ms > 0)
+        {
+            n = snprintf(batch + used, sizeof(batch) - used, "%s{\"ts\":%lld,\"values\":%s}",
+                         count ? "," : "", (long long)ts_ms, values);
+        }
+        else
+        {
+            n = snprintf(batch + used, sizeof(batch) - used, "%s%s", count ? "," : "", values);
+        }
+        // Keep room for the closing bracket
+        if (n < 0 || used + n + 2 > sizeof(batch))
+        {
+            break;
+        }
+        used += n;
+        count++;
+        offset = file.position();
+    }
+    file.close();
+    batch[used++] = ']';
+    batch[used] = '\0';
+
+    if (count > 0 && !publish(batch, used))
+    {
+        return 0;
+    }
+
+    read_offset = offset;
+    if (segment_done)
+    {
+        retire_first_segment();
+    }
+    save_cursor();
+    return count;
+}
+
+bool telemetry_journal_empty()
+{
+    return !have_segments;
+}
+
+uint32_t telemetry_journal_dropped()
+{
+    return dropped_records;
+}
@@ -2,34 +2,61 @@
 DHT20 dht20;
 LiquidCrystal_I2C lcd(33,16,2);
 
+#define DHT20_READ_TIMEOUT_MS (3 * DHT20_CONVERSION_TIME)
+
+// Runs in the esp_timer task when the DHT20 conversion time has passed
+static void dht20_ready(void *arg) {
+    xTaskNotifyGive((TaskHandle_t)arg);
+}
 
 void temp_humi_monitor(void *pvParameters){
 
-    Wire.begin(11, 12);
+    // The bus task owns Wire; sensor reads jump ahead of queued LCD traffic
+    i2c_bus_begin(11, 12);
     Serial.begin(115200);
+    dht20.setTransfer(i2c_bus_transfer_hook, (void *)I2C_PRIORITY_HIGH);
+    lcd.setTransfer(i2c_bus_transfer_hook, (void *)I2C_PRIORITY_LOW);
     dht20.begin();
+    dht20.setReadyCallback(dht20_ready, xTaskGetCurrentTaskHandle());
 
     while (1){
         /* code */
-        
-        dht20.read();
+
+        // Trigger the conversion and sleep until the one-shot timer says it is done,
+        // the I2C bus stays free for the LCD in the meantime
+        // A sensor stuck at busy is given up after DHT20_READ_TIMEOUT_MS and reported as a failed read
+        int status = dht20.startConversion();
+        if (status == DHT20_OK) {
+            const uint32_t started = millis();
+            do {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2 * DHT20_CONVERSION_TIME));
+                status = dht20.collect();
+            } while (status == DHT20_ERROR_BUSY && millis() - started < DHT20_READ_TIMEOUT_MS);
+            if (status == DHT20_ERROR_BUSY) {
+                status = DHT20_ERROR_READ_TIMEOUT;
+            }
+        }
+
         // Reading temperature in Celsius
         float temperature = dht20.getTemperature();
         // Reading humidity
         float humidity = dht20.getHumidity();
 
-        
-
         // Check if any reads failed and exit early
-        if (isnan(temperature) || isnan(humidity)) {
+        bool valid = true;
+        if (status != DHT20_OK || isnan(temperature) || isnan(humidity)) {
             Serial.println("Failed to read from DHT sensor!");
             temperature = humidity =  -1;
+            valid = false;
             //return;
         }
 
-        //Update global variables for temperature and humidity
-        glob_temperature = temperature;
-        glob_humidity = humidity;
+        //Publish temperature and humidity as one consistent snapshot
+        sensor_snapshot_publish(temperature, humidity, valid);
+        if (valid) {
+            sensor_history_record(SENSOR_TEMPERATURE, temperature);
+            sensor_history_record(SENSOR_HUMIDITY, humidity);
+        }
 
         // Print the results
         
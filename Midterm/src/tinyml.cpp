@@ -42,11 +42,17 @@ void setupTinyML() {
 void TaskTinyML(void *pvParameters) {
   const TickType_t period = pdMS_TO_TICKS(1000);
   TickType_t lastWake = xTaskGetTickCount();
+  uint32_t lastSequence = 0;
 
   while (true) {
-    // --- Read sensor data ---
-    float t = getTemperature();
-    float h = getHumidity();
+    // --- Read sensor data (skip inference if no new sample) ---
+    SensorSnapshot snapshot;
+    if (!sensor_snapshot_read_newer(lastSequence, snapshot) || !snapshot.valid) {
+      vTaskDelayUntil(&lastWake, period);
+      continue;
+    }
+    float t = snapshot.temperature;
+    float h = snapshot.humidity;
     Serial.printf("[TinyML] Temp=%.2f°C, Humi=%.2f%%\n", t, h);
 
     // --- Normalize input ---